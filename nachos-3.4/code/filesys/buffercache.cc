@@ -0,0 +1,488 @@
+// buffercache.cc
+//	Routines to manage a cache of disk sectors.
+//
+//	A single lock protects the whole cache, but it is never held
+//	while waiting for the disk: a buffer being read in or written
+//	back is marked busy instead, and anyone else who wants it waits
+//	on the "changed" condition until it isn't.
+//
+// Copyright (c) 1992-1993 The Regents of the University of California.
+// All rights reserved.  See copyright.h for copyright notice and limitation
+// of liability and disclaimer of warranty provisions.
+
+#include "copyright.h"
+#include "buffercache.h"
+#include "system.h"
+
+//----------------------------------------------------------------------
+// BufferCache::BufferCache
+// 	Initialize a cache with no sectors in it.
+//
+//	"vol" is the disk (or volume) whose sectors are cached.
+//	"num" is the number of sectors the cache holds.
+//----------------------------------------------------------------------
+
+BufferCache::BufferCache(Volume *vol, int num)
+{
+    disk = vol;
+    numBuffers = num;
+    buffers = new CacheBuffer[numBuffers];
+    hashTable = new CacheBuffer *[numBuffers];
+    lock = new Lock("buffer cache lock");
+    changed = new Condition("buffer cache changed");
+    readAheadPool = NULL;
+
+    lruHead = lruTail = NULL;
+    for (int i = 0; i < numBuffers; i++) {
+	buffers[i].sector = -1;
+	buffers[i].dirty = buffers[i].busy = FALSE;
+	buffers[i].pinCount = 0;
+	buffers[i].hashNext = NULL;
+	hashTable[i] = NULL;
+
+	buffers[i].lruPrev = lruTail;		// put it at the back
+	buffers[i].lruNext = NULL;
+	if (lruTail != NULL)
+	    lruTail->lruNext = &buffers[i];
+	else
+	    lruHead = &buffers[i];
+	lruTail = &buffers[i];
+    }
+}
+
+//----------------------------------------------------------------------
+// BufferCache::~BufferCache
+// 	Write back everything that is dirty, then de-allocate the cache.
+//
+//	The read-ahead worker is left alone: this is only done when Nachos
+//	is halting, by which time it is idle for good.
+//----------------------------------------------------------------------
+
+BufferCache::~BufferCache()
+{
+    Sync();
+    delete changed;
+    delete lock;
+    delete [] hashTable;
+    delete [] buffers;
+}
+
+//----------------------------------------------------------------------
+// BufferCache::Lookup, HashInsert, HashRemove
+// 	Find the buffer holding a sector, if any; add a buffer to, or
+//	remove it from, the hash table, under the sector it holds.
+//	Called with the lock held.
+//----------------------------------------------------------------------
+
+CacheBuffer *
+BufferCache::Lookup(int sector)
+{
+    CacheBuffer *b;
+
+    for (b = hashTable[sector % numBuffers]; b != NULL; b = b->hashNext)
+	if (b->sector == sector)
+	    return b;
+    return NULL;
+}
+
+void
+BufferCache::HashInsert(CacheBuffer *buffer)
+{
+    CacheBuffer **bucket = &hashTable[buffer->sector % numBuffers];
+
+    buffer->hashNext = *bucket;
+    *bucket = buffer;
+}
+
+void
+BufferCache::HashRemove(CacheBuffer *buffer)
+{
+    CacheBuffer **b;
+
+    for (b = &hashTable[buffer->sector % numBuffers]; *b != buffer;
+							b = &(*b)->hashNext)
+	ASSERT(*b != NULL);
+    *b = buffer->hashNext;
+}
+
+//----------------------------------------------------------------------
+// BufferCache::Touch
+// 	"buffer" has just been used; move it to the front of the least
+//	recently used list.  Called with the lock held.
+//----------------------------------------------------------------------
+
+void
+BufferCache::Touch(CacheBuffer *buffer)
+{
+    if (buffer == lruHead)
+	return;
+    buffer->lruPrev->lruNext = buffer->lruNext;		// take it out
+    if (buffer->lruNext != NULL)
+	buffer->lruNext->lruPrev = buffer->lruPrev;
+    else
+	lruTail = buffer->lruPrev;
+
+    buffer->lruPrev = NULL;				// put it in front
+    buffer->lruNext = lruHead;
+    lruHead->lruPrev = buffer;
+    lruHead = buffer;
+}
+
+//----------------------------------------------------------------------
+// BufferCache::ChooseVictim
+// 	Return the least recently used buffer that can be given over to
+//	another sector -- one that no one has pinned, and that isn't
+//	busy -- or NULL if there isn't one.  Called with the lock held.
+//----------------------------------------------------------------------
+
+CacheBuffer *
+BufferCache::ChooseVictim()
+{
+    CacheBuffer *b;
+
+    for (b = lruTail; b != NULL; b = b->lruPrev)
+	if (b->pinCount == 0 && !b->busy)
+	    return b;
+    return NULL;
+}
+
+//----------------------------------------------------------------------
+// BufferCache::WriteBack
+// 	Write a dirty buffer back to the disk, along with the dirty
+//	buffers for the sectors either side of it, as one request.
+//	Called with the lock held, but lets go of it while waiting for
+//	the disk.
+//
+//	The buffers are marked clean before the write, so that if someone
+//	with one pinned changes it in the meantime, it is dirty again
+//	afterwards.
+//----------------------------------------------------------------------
+
+void
+BufferCache::WriteBack(CacheBuffer *buffer)
+{
+    CacheBuffer *run[MaxCacheRun];
+    char *data[MaxCacheRun];
+    CacheBuffer *b;
+    int first, n;
+
+    ASSERT(buffer->dirty && !buffer->busy);
+    for (first = buffer->sector; first > 0; first--) {	// find the start
+	b = Lookup(first - 1);
+	if (b == NULL || !b->dirty || b->busy
+			|| buffer->sector - (first - 1) >= MaxCacheRun)
+	    break;
+    }
+    for (n = 0; n < MaxCacheRun; n++) {
+	b = Lookup(first + n);
+	if (b == NULL || !b->dirty || b->busy)
+	    break;
+	b->dirty = FALSE;
+	b->busy = TRUE;
+	run[n] = b;
+	data[n] = b->data;
+    }
+    ASSERT(n > 0 && !buffer->dirty);
+
+    DEBUG('f', "Buffer cache writing back sectors %d to %d\n",
+							first, first + n - 1);
+    lock->Release();
+    disk->WriteSectors(first, n, data);
+    lock->Acquire();
+    for (int i = 0; i < n; i++)
+	run[i]->busy = FALSE;
+    changed->Broadcast(lock);
+}
+
+//----------------------------------------------------------------------
+// BufferCache::Claim
+// 	Return the buffer holding "sector", setting "*hit" TRUE.  If the
+//	sector isn't in the cache, take over the least recently used
+//	buffer (writing it back first, if it is dirty), and return that
+//	instead, with "*hit" FALSE -- it is up to the caller to fill it
+//	in, before letting go of the lock.
+//
+//	Called with the lock held; it may be let go of in between, while
+//	waiting for the disk or for other threads.
+//----------------------------------------------------------------------
+
+CacheBuffer *
+BufferCache::Claim(int sector, bool *hit)
+{
+    CacheBuffer *b;
+
+    for (;;) {
+	b = Lookup(sector);
+	if (b != NULL) {
+	    if (b->busy) {		// wait until it's been read in, or
+		changed->Wait(lock);	// written back
+		continue;
+	    }
+	    stats->numCacheHits++;
+	    *hit = TRUE;
+	    return b;
+	}
+
+	b = ChooseVictim();
+	if (b == NULL) {		// everything is pinned or busy
+	    changed->Wait(lock);
+	    continue;
+	}
+	if (b->dirty) {			// the lock is let go while writing,
+	    WriteBack(b);		// so look again from the start
+	    continue;
+	}
+
+	stats->numCacheMisses++;
+	DEBUG('f', "Buffer cache miss on sector %d, replacing %d\n",
+						sector, b->sector);
+	if (b->sector != -1)
+	    HashRemove(b);
+	b->sector = sector;
+	HashInsert(b);
+	*hit = FALSE;
+	return b;
+    }
+}
+
+//----------------------------------------------------------------------
+// BufferCache::ReadRun
+// 	Read consecutive sectors from the disk, with one request, into
+//	the buffers claimed for them, which the caller has marked busy.
+//	Then, if "into" isn't NULL, copy them there too.
+//
+//	Called with the lock held, but lets go of it while waiting for
+//	the disk.
+//----------------------------------------------------------------------
+
+void
+BufferCache::ReadRun(CacheBuffer **run, int numSectors, char *into)
+{
+    char *data[MaxCacheRun];
+
+    for (int i = 0; i < numSectors; i++)
+	data[i] = run[i]->data;
+    lock->Release();
+    disk->ReadSectors(run[0]->sector, numSectors, data);
+    lock->Acquire();
+    for (int i = 0; i < numSectors; i++) {
+	run[i]->busy = FALSE;
+	if (into != NULL)
+	    bcopy(run[i]->data, &into[i * SectorSize], SectorSize);
+    }
+    changed->Broadcast(lock);
+}
+
+//----------------------------------------------------------------------
+// BufferCache::Find
+// 	Return the buffer holding "sector", with the lock held.  If the
+//	sector isn't in the cache, read it in, if "fill" is TRUE -- if
+//	not, the caller is about to overwrite all of it.
+//----------------------------------------------------------------------
+
+CacheBuffer *
+BufferCache::Find(int sector, bool fill)
+{
+    CacheBuffer *b;
+    bool hit;
+
+    lock->Acquire();
+    b = Claim(sector, &hit);
+    if (!hit && fill) {
+	b->busy = TRUE;
+	ReadRun(&b, 1, NULL);
+    }
+    Touch(b);
+    return b;
+}
+
+//----------------------------------------------------------------------
+// BufferCache::ReadSector
+// 	Copy the contents of "sector" into "data", reading it from the
+//	disk only if it isn't in the cache.
+//----------------------------------------------------------------------
+
+void
+BufferCache::ReadSector(int sector, char *data)
+{
+    CacheBuffer *b = Find(sector, TRUE);
+
+    bcopy(b->data, data, SectorSize);
+    lock->Release();
+}
+
+//----------------------------------------------------------------------
+// BufferCache::ReadSectors
+// 	Copy the contents of "numSectors" consecutive sectors, starting
+//	at "sector", into "data".  The sectors that are in the cache are
+//	copied from there; each run of ones that aren't is read in with
+//	one disk request.
+//
+//	If "data" is NULL, the sectors are just brought into the cache.
+//----------------------------------------------------------------------
+
+void
+BufferCache::ReadSectors(int sector, int numSectors, char *data)
+{
+    CacheBuffer *run[MaxCacheRun];
+    CacheBuffer *b;
+    int n = 0;				// # of sectors in the run so far
+    bool hit;
+
+    lock->Acquire();
+    for (int i = 0; i < numSectors; i++) {
+	b = Claim(sector + i, &hit);
+	Touch(b);
+	if (hit) {
+	    if (data != NULL)
+		bcopy(b->data, &data[i * SectorSize], SectorSize);
+	    if (n > 0)			// the run is broken; read it in
+		ReadRun(run, n, (data == NULL) ? NULL
+					: &data[(i - n) * SectorSize]);
+	    n = 0;
+	    continue;
+	}
+	b->busy = TRUE;			// ours, until it has been read
+	run[n++] = b;
+	if (n == MaxCacheRun) {
+	    ReadRun(run, n, (data == NULL) ? NULL
+					: &data[(i + 1 - n) * SectorSize]);
+	    n = 0;
+	}
+    }
+    if (n > 0)
+	ReadRun(run, n, (data == NULL) ? NULL
+				: &data[(numSectors - n) * SectorSize]);
+    lock->Release();
+}
+
+//----------------------------------------------------------------------
+// BufferCache::ReadAhead
+// 	Arrange for "numSectors" consecutive sectors, starting at
+//	"sector", to be read into the cache by the read-ahead worker,
+//	and return without waiting.  Sectors at either end of the run
+//	that are already cached are left off.
+//----------------------------------------------------------------------
+
+class ReadAheadRequest {
+  public:
+    BufferCache *cache;
+    int sector;
+    int numSectors;
+};
+
+static int
+DoReadAhead(IntPtr arg)
+{
+    ReadAheadRequest *request = (ReadAheadRequest *) arg;
+
+    request->cache->ReadSectors(request->sector, request->numSectors, NULL);
+    delete request;
+    return 0;
+}
+
+void
+BufferCache::ReadAhead(int sector, int numSectors)
+{
+    ReadAheadRequest *request;
+
+    lock->Acquire();
+    while (numSectors > 0 && Lookup(sector) != NULL) {
+	sector++;
+	numSectors--;
+    }
+    while (numSectors > 0 && Lookup(sector + numSectors - 1) != NULL)
+	numSectors--;
+    lock->Release();
+    if (numSectors == 0)
+	return;
+
+    DEBUG('f', "Buffer cache reading ahead sectors %d to %d\n",
+					sector, sector + numSectors - 1);
+    stats->numCacheReadAheads += numSectors;
+    if (readAheadPool == NULL)
+	readAheadPool = new WorkPool("read-ahead", 1);
+    request = new ReadAheadRequest;
+    request->cache = this;
+    request->sector = sector;
+    request->numSectors = numSectors;
+    readAheadPool->Post(DoReadAhead, (IntPtr) request);
+}
+
+//----------------------------------------------------------------------
+// BufferCache::WriteSector
+// 	Copy "data" into the cache as the new contents of "sector".  It
+//	is written to the disk later, when its buffer is reused or the
+//	cache is synced.
+//----------------------------------------------------------------------
+
+void
+BufferCache::WriteSector(int sector, char *data)
+{
+    CacheBuffer *b = Find(sector, FALSE);
+
+    bcopy(data, b->data, SectorSize);
+    b->dirty = TRUE;
+    lock->Release();
+}
+
+//----------------------------------------------------------------------
+// BufferCache::Pin
+// 	Return the buffer holding "sector" (reading it in if needed),
+//	for the caller to read or change in place.  The buffer stays
+//	put until the caller calls Unpin.
+//----------------------------------------------------------------------
+
+char *
+BufferCache::Pin(int sector)
+{
+    CacheBuffer *b = Find(sector, TRUE);
+
+    b->pinCount++;
+    lock->Release();
+    return b->data;
+}
+
+//----------------------------------------------------------------------
+// BufferCache::Unpin
+// 	The caller is done with the buffer it pinned for "sector";
+//	"dirty" is TRUE if it changed it.
+//----------------------------------------------------------------------
+
+void
+BufferCache::Unpin(int sector, bool dirty)
+{
+    CacheBuffer *b;
+
+    lock->Acquire();
+    b = Lookup(sector);
+    ASSERT(b != NULL && b->pinCount > 0);
+    if (dirty)
+	b->dirty = TRUE;
+    if (--b->pinCount == 0)
+	changed->Broadcast(lock);
+    lock->Release();
+}
+
+//----------------------------------------------------------------------
+// BufferCache::Sync
+// 	Write back every dirty sector, so that the disk is up to date.
+//----------------------------------------------------------------------
+
+void
+BufferCache::Sync()
+{
+    CacheBuffer *b;
+
+    lock->Acquire();
+    for (int i = 0; i < numBuffers; i++) {
+	b = &buffers[i];
+	while (b->dirty) {
+	    if (b->busy)
+		changed->Wait(lock);
+	    else
+		WriteBack(b);
+	}
+    }
+    lock->Release();
+}
@@ -0,0 +1,110 @@
+// buffercache.h
+//	Data structures for a cache of disk sectors, kept in memory in
+//	front of the synchronous disk.
+//
+//	The file system reads and writes sectors through the cache.  A
+//	sector that is already in the cache is read without going to the
+//	disk; a sector that is written is only marked dirty, and is
+//	written back to the disk when its buffer is needed for another
+//	sector, or when the cache is synced.  Buffers are reused least
+//	recently used first.
+//
+//	A caller can also "pin" a sector's buffer, to work on it in
+//	place; a pinned buffer is never reused for another sector.
+//
+//	Sectors can also be read ahead, in the background, by a kernel
+//	worker thread, so that they are in the cache by the time someone
+//	reads them.
+//
+// Copyright (c) 1992-1993 The Regents of the University of California.
+// All rights reserved.  See copyright.h for copyright notice and limitation
+// of liability and disclaimer of warranty provisions.
+
+#ifndef BUFFERCACHE_H
+#define BUFFERCACHE_H
+
+#include "copyright.h"
+#include "disk.h"
+#include "synch.h"
+#include "volume.h"
+#include "workpool.h"
+
+#define NumCacheBuffers	64		// # of sectors the cache holds
+#define MaxCacheRun	16		// most sectors read or written back
+					// with one disk request
+
+// The following class defines one buffer in the cache, holding
+// (a copy of) one disk sector.
+//
+// Internal data structures kept public so that BufferCache operations
+// can access them directly.
+
+class CacheBuffer {
+  public:
+    int sector;			// which sector; -1 if the buffer is unused
+    char data[SectorSize];	// the sector's contents
+    bool dirty;			// changed since it was read or written?
+    bool busy;			// being read in, or written back?
+    int pinCount;		// # of callers working on it in place
+
+    CacheBuffer *hashNext;	// next buffer in the same hash bucket
+    CacheBuffer *lruPrev;	// neighbours in least recently used
+    CacheBuffer *lruNext;	// order; most recent at the front
+};
+
+// The following class defines the buffer cache.
+
+class BufferCache {
+  public:
+    BufferCache(Volume *vol, int numBuffers);	// initialize an
+					// empty cache in front of "vol"
+    ~BufferCache();			// write back all dirty sectors, and
+					// de-allocate the cache
+
+    void ReadSector(int sector, char *data);	// copy a sector out of
+					// the cache, reading it in if needed
+    void WriteSector(int sector, char *data);	// copy a whole sector
+					// into the cache, and mark it dirty
+    void ReadSectors(int sector, int numSectors, char *data);
+					// copy consecutive sectors out of
+					// the cache, reading in the missing
+					// ones with as few requests as can be
+    void ReadAhead(int sector, int numSectors);	// start reading
+					// consecutive sectors into the cache,
+					// and return at once
+
+    char *Pin(int sector);		// return the sector's buffer, for
+					// the caller to work on in place
+    void Unpin(int sector, bool dirty);	// done with it; "dirty" if the
+					// caller changed it
+
+    void Sync();			// write back every dirty sector
+
+  private:
+    Volume *disk;			// where the sectors really live
+    CacheBuffer *buffers;		// all the buffers
+    int numBuffers;
+    CacheBuffer **hashTable;		// buffers, hashed by sector
+    CacheBuffer *lruHead;		// most recently used buffer
+    CacheBuffer *lruTail;		// least recently used buffer
+    Lock *lock;				// protects all of the above
+    Condition *changed;			// a buffer has stopped being busy,
+					// or been unpinned
+    WorkPool *readAheadPool;		// reads ahead; NULL until needed
+
+    CacheBuffer *Find(int sector, bool fill);	// find or load a sector
+    CacheBuffer *Claim(int sector, bool *hit);	// find a sector, or give
+					// it a buffer without reading it
+    void ReadRun(CacheBuffer **run, int numSectors, char *into);
+					// read consecutive sectors into
+					// the buffers claimed for them
+    CacheBuffer *Lookup(int sector);	// find a sector, if it is cached
+    CacheBuffer *ChooseVictim();	// buffer to reuse, or NULL if none
+    void WriteBack(CacheBuffer *buffer);	// write a dirty buffer out,
+					// with any dirty neighbours
+    void HashInsert(CacheBuffer *buffer);
+    void HashRemove(CacheBuffer *buffer);
+    void Touch(CacheBuffer *buffer);	// move to the front of the LRU list
+};
+
+#endif // BUFFERCACHE_H
@@ -184,6 +184,7 @@ char* Directory::FindName(int sector)
 	for (int i = 0; i < tableSize; i++)
         	if (table[i].sector == sector)
 			return table[i].name;
+	return NULL;		// no such file in this directory
 }
 //----------------------------------------------------------------------
 // Directory::Remove
@@ -311,7 +312,7 @@ Directory::Print()
 char
 *Directory::DirGetCurrentDate()
 {
-	char str[StringMaxLen];
+	static char str[StringMaxLen];	// must outlive the call
 	GetCurrentDate(str,StringMaxLen);
 	return str;
        	
@@ -326,7 +327,7 @@ char
 char
 *Directory::DirGetCurrentTime()
 {
-	char str[StringMaxLen];
+	static char str[StringMaxLen];	// must outlive the call
 	GetCurrentTime(str,StringMaxLen);
 	return str;
 }
@@ -0,0 +1,138 @@
+// disktrace.cc
+//	Routines to trace disk requests, and write the trace out as CSV:
+//
+//		finished,disk,sector,sectors,op,thread,queue,seek tracks,
+//			seek,rotation,transfer
+//
+//	with times in ticks.  The disk and thread names are quoted, so
+//	that a comma or quote in one doesn't break the line.  Lines go
+//	out through a TraceWriter (cf. stats.h), which buffers them.
+//
+// Copyright (c) 1992-1993 The Regents of the University of California.
+// All rights reserved.  See copyright.h for copyright notice and limitation
+// of liability and disclaimer of warranty provisions.
+
+#include "copyright.h"
+#include "disktrace.h"
+#include "system.h"
+
+//----------------------------------------------------------------------
+// QuoteField
+// 	Copy up to TraceNameLength characters of "name" into "quoted",
+//	which must have room for QuotedFieldSize, as a quoted CSV field:
+//	in double quotes, with any '"' doubled, and control characters
+//	(such as a newline, which would end the line) replaced with '?'.
+//	Returns "quoted".
+//----------------------------------------------------------------------
+
+static char *
+QuoteField(char *name, char *quoted)
+{
+    int n = 0;
+
+    quoted[n++] = '"';
+    for (int i = 0; i < TraceNameLength && name[i] != '\0'; i++) {
+	if (name[i] == '"')
+	    quoted[n++] = '"';
+	quoted[n++] = ((unsigned char) name[i] < ' ') ? '?' : name[i];
+    }
+    quoted[n++] = '"';
+    quoted[n] = '\0';
+    return quoted;
+}
+
+//----------------------------------------------------------------------
+// PrintHistogram
+// 	Print the mean and maximum of "h", labelled "title", and then
+//	its buckets; nothing at all if it is empty.
+//----------------------------------------------------------------------
+
+static void
+PrintHistogram(char *title, Histogram *h)
+{
+    if (h->count == 0)
+	return;
+    printf("%s: mean %d, max %d\n", title, h->total / h->count, h->max);
+    h->Print();
+}
+
+//----------------------------------------------------------------------
+// DiskTracer::DiskTracer
+// 	Start tracing disk requests.  If "fileName" isn't NULL, write the
+//	trace there (overwriting it if it exists).
+//----------------------------------------------------------------------
+
+DiskTracer::DiskTracer(char *fileName)
+{
+    numReads = numWrites = numSectors = 0;
+    file = NULL;
+    if (fileName != NULL) {
+	file = new TraceWriter(fileName);
+	file->Write("finished,disk,sector,sectors,op,thread,queue,"
+			"seek tracks,seek,rotation,transfer\n");
+    }
+}
+
+//----------------------------------------------------------------------
+// DiskTracer::~DiskTracer
+// 	Write out the rest of the trace, and close it.
+//----------------------------------------------------------------------
+
+DiskTracer::~DiskTracer()
+{
+    delete file;
+}
+
+//----------------------------------------------------------------------
+// DiskTracer::Record
+// 	A request to the disk "diskName" has just finished: add a line to
+//	the trace, and its times to the histograms.
+//----------------------------------------------------------------------
+
+void
+DiskTracer::Record(char *diskName, DiskRequest *request)
+{
+    DiskLatency *l = &request->latency;
+    int waited = request->started - request->arrival;
+    char line[2 * QuotedFieldSize + 120];
+    char disk[QuotedFieldSize], thread[QuotedFieldSize];
+
+    if (request->writing)
+	numWrites++;
+    else
+	numReads++;
+    numSectors += request->numSectors;
+    queue.Add(waited);
+    seekTracks.Add(l->seekTracks);
+    seek.Add(l->seek);
+    rotation.Add(l->rotation);
+    transfer.Add(l->transfer);
+    total.Add(stats->totalTicks - request->arrival);
+
+    if (file == NULL)
+	return;
+    snprintf(line, sizeof(line), "%d,%s,%d,%d,%c,%s,%d,%d,%d,%d,%d\n",
+		stats->totalTicks, QuoteField(diskName, disk), request->sector,
+		request->numSectors, request->writing ? 'W' : 'R',
+		QuoteField(request->requester, thread), waited, l->seekTracks,
+		l->seek, l->rotation, l->transfer);
+    file->Write(line);
+}
+
+//----------------------------------------------------------------------
+// DiskTracer::Print
+// 	Print how many requests there were, and the histograms.
+//----------------------------------------------------------------------
+
+void
+DiskTracer::Print()
+{
+    printf("Disk requests: reads %d, writes %d, sectors %d\n", numReads,
+	numWrites, numSectors);
+    PrintHistogram("Queue ticks", &queue);
+    PrintHistogram("Seek tracks", &seekTracks);
+    PrintHistogram("Seek ticks", &seek);
+    PrintHistogram("Rotational delay ticks", &rotation);
+    PrintHistogram("Transfer ticks", &transfer);
+    PrintHistogram("Total ticks", &total);
+}
@@ -0,0 +1,55 @@
+// disktrace.h
+//	Data structures for tracing disk requests: for each request, when
+//	it was made, which disk and sectors it was for, which thread made
+//	it, and where its time went -- waiting in the queue, seeking,
+//	waiting for the sector to come round, and transferring the data.
+//
+//	The trace is written as CSV, one line per request, in the order
+//	the requests finished.  Histograms of each part of the time, and
+//	of seek distances, are kept as well, and printed when Nachos
+//	halts.
+//
+//	Tracing is off unless Nachos is started with "-dtrace <file>"
+//	(write the trace), or "-dstat" (just print the histograms).
+//
+// Copyright (c) 1992-1993 The Regents of the University of California.
+// All rights reserved.  See copyright.h for copyright notice and limitation
+// of liability and disclaimer of warranty provisions.
+
+#ifndef DISKTRACE_H
+#define DISKTRACE_H
+
+#include "copyright.h"
+#include "stats.h"
+#include "synchdisk.h"
+
+#define QuotedFieldSize	(2 * TraceNameLength + 3)	// room for a
+					// name, quoted for CSV
+
+// The following class defines the disk tracer.  Record is called by
+// SynchDisk, with interrupts disabled, as each request finishes.
+
+class DiskTracer {
+  public:
+    DiskTracer(char *fileName);		// start tracing, writing the trace
+					// to "fileName" unless it is NULL
+    ~DiskTracer();			// finish the trace, and close it
+
+    void Record(char *diskName, DiskRequest *request);
+					// a request to "diskName" is done
+    void Print();			// print the histograms
+
+  private:
+    TraceWriter *file;			// the trace file; NULL if none
+
+    int numReads, numWrites;		// # of requests of each kind
+    int numSectors;			// # of sectors they moved
+    Histogram queue;			// ticks waiting in the queue
+    Histogram seekTracks;		// # of tracks seeked
+    Histogram seek;			// ticks seeking
+    Histogram rotation;			// ticks of rotational delay
+    Histogram transfer;			// ticks transferring
+    Histogram total;			// ticks from request to completion
+};
+
+#endif // DISKTRACE_H
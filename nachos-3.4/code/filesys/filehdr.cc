@@ -27,6 +27,25 @@
 #include "system.h"
 #include "filehdr.h"
 
+//----------------------------------------------------------------------
+// FileHeader::AllocateToDataSectors
+// 	Fill in "dataSectors" with free sectors.  The whole file is
+//	allocated at once, so take them as one run of sectors next to
+//	each other on disk if there is one, so that they can be read
+//	and written back together; failing that, one at a time,
+//	wherever they are free.
+//----------------------------------------------------------------------
+
+void
+FileHeader::AllocateToDataSectors(BitMap *freeMap, int numSectors, int dataSectors[])
+{
+	int i;
+	int first = freeMap->FindRun(numSectors + 1);
+
+	for(i=0;i<=numSectors;i++)
+		dataSectors[i] = (first != -1) ? first + i : freeMap->Find();
+}
+
 //----------------------------------------------------------------------
 // FileHeader::Allocate
 // 	Initialize a fresh file header for a newly created file.
@@ -38,14 +57,6 @@
 //	"fileSize" is the bit map of free disk sectors
 //----------------------------------------------------------------------
 
-void
-FileHeader::AllocateToDataSectors(BitMap *freeMap, int numSectors, int dataSectors[])
-{
-	int i;
-	for(i=0;i<=numSectors;i++)
-		dataSectors[i] = freeMap->Find();
-}
-
 bool
 FileHeader::Allocate(BitMap *freeMap, int fileSize)
 { 
@@ -78,7 +89,7 @@ FileHeader::Allocate(BitMap *freeMap, int fileSize)
 		   
 	//   printf("write the last sector to subSectors = %d\n", subSectors-1);
 	 //  printf("write dataSectors2 to dataSectors[%d]\n",lastIndex);
-	   synchDisk->WriteSector(dataSectors[lastIndex],(char *)dataSectors2);
+	   bufferCache->WriteSector(dataSectors[lastIndex],(char *)dataSectors2);
    }
     return TRUE;
 }
@@ -100,7 +111,7 @@ FileHeader::Deallocate(BitMap *freeMap)
     {
     	int subSectors = numSectors - lastIndex;
 	int dataSectors2[lastIndex];
-	synchDisk->ReadSector(dataSectors[lastIndex],(char *)dataSectors2);
+	bufferCache->ReadSector(dataSectors[lastIndex],(char *)dataSectors2);
     	for(int i = 0; i < subSectors;i++)
 	{
 		ASSERT(freeMap->Test((int) dataSectors2[i]));  // ought to be marked!
@@ -130,7 +141,7 @@ void
 FileHeader::FetchFrom(int sector)
 {
 //	printf("FetchFrom at sector=%d\n", sector);
-    synchDisk->ReadSector(sector, (char *)this);
+    bufferCache->ReadSector(sector, (char *)this);
  //   printf("this->numBytes = %d\n",this->numBytes);
 }
 
@@ -144,7 +155,7 @@ FileHeader::FetchFrom(int sector)
 void
 FileHeader::WriteBack(int sector)
 {
-    synchDisk->WriteSector(sector, (char *)this); 
+    bufferCache->WriteSector(sector, (char *)this); 
 }
 
 //----------------------------------------------------------------------
@@ -165,7 +176,7 @@ FileHeader::ByteToSector(int offset)
     {
 	int dataSectors2[lastIndex];
 	//printf("ByteToSector:dataSector[%d]\t",lastIndex);
-	synchDisk->ReadSector(dataSectors[lastIndex],(char *)dataSectors2);
+	bufferCache->ReadSector(dataSectors[lastIndex],(char *)dataSectors2);
 	//printf("ByteToSector:offset = %d, SectorSize = %d, SectorNumber = %d, dataSector2[%d]=%d\n", offset, SectorSize, offset / SectorSize, offset / SectorSize - lastIndex, dataSectors2[offset / SectorSize - lastIndex]);
     	return(dataSectors2[offset / SectorSize - lastIndex]);
     }
@@ -216,7 +227,7 @@ FileHeader::Print()
 	printf("%d ", dataSectors[i]);
     printf("\nLevel 1 File contents:\n");
     for (i = k = 0; i < numSectors; i++) {
-	synchDisk->ReadSector(dataSectors[i], data);
+	bufferCache->ReadSector(dataSectors[i], data);
        	for (j = 0; (j < SectorSize) && (k < numBytes); j++, k++) {
     		if ('\040' <= data[j] && data[j] <= '\176')   // isprint(data[j])
 			printf("%c", data[j]);
@@ -232,7 +243,7 @@ FileHeader::Print()
 	printf("%d ", dataSectors[i]);
     int dataSectors2[lastIndex];
     //printf("ReadSector from lastIndex:%d\n",dataSectors[lastIndex]);
-    synchDisk->ReadSector(dataSectors[lastIndex],(char *)dataSectors2); 
+    bufferCache->ReadSector(dataSectors[lastIndex],(char *)dataSectors2); 
     subSectors = numSectors - lastIndex;
     for (i = 0; i < subSectors; i++)
 	printf("%d ", dataSectors2[i]);
@@ -240,7 +251,7 @@ FileHeader::Print()
     printf("\nLevel 1 & 2 File contents:\n");
 
     for (i = k = 0; i < lastIndex; i++) {
-	synchDisk->ReadSector(dataSectors[i], data);
+	bufferCache->ReadSector(dataSectors[i], data);
        	for (j = 0; (j < SectorSize) && (k < numBytes); j++, k++) {
     		if ('\040' <= data[j] && data[j] <= '\176')   // isprint(data[j])
 			printf("%c", data[j]);
@@ -250,7 +261,7 @@ FileHeader::Print()
        	printf("\n"); 
     	}
     for (i = k = 0; i < subSectors; i++) {
-	synchDisk->ReadSector(dataSectors2[i], data);
+	bufferCache->ReadSector(dataSectors2[i], data);
        	for (j = 0; (j < SectorSize) && (k < numBytes); j++, k++) {
     		if ('\040' <= data[j] && data[j] <= '\176')   // isprint(data[j])
 			printf("%c", data[j]);
@@ -64,7 +64,8 @@
 // Initial file sizes for the bitmap and directory; until the file system
 // supports extensible files, the directory size sets the maximum number 
 // of files that can be loaded onto the disk.
-#define FreeMapFileSize 	(NumSectors / BitsInByte)
+#define FreeMapFileSize 	(divRoundUp(volume->NumSectors(), BitsInWord) \
+					* sizeof(unsigned int))
 #define NumDirEntries 		12
 #define DirectoryFileSize 	(sizeof(DirectoryEntry) * NumDirEntries)
 
@@ -85,7 +86,7 @@ FileSystem::FileSystem(bool format)
 { 
     DEBUG('f', "Initializing the file system.\n");
     if (format) {
-        BitMap *freeMap = new BitMap(NumSectors);
+        BitMap *freeMap = new BitMap(volume->NumSectors());
         Directory *directory = new Directory(NumDirEntries);
 	FileHeader *mapHdr = new FileHeader;
 	FileHeader *dirHdr = new FileHeader;
@@ -201,7 +202,7 @@ FileSystem::Create(char *name, int initialSize, char filetype)	//edit by YePeng
     if (directory->Find(name) != -1)
       success = FALSE;			// file is already in directory
     else {	
-        freeMap = new BitMap(NumSectors);
+        freeMap = new BitMap(volume->NumSectors());
         freeMap->FetchFrom(freeMapFile);
         sector = freeMap->Find();	// find a sector to hold the file header
     	if (sector == -1) 		
@@ -340,7 +341,7 @@ FileSystem::Remove(char *name)
     fileHdr = new FileHeader;
     fileHdr->FetchFrom(sector);
 
-    freeMap = new BitMap(NumSectors);
+    freeMap = new BitMap(volume->NumSectors());
     freeMap->FetchFrom(freeMapFile);
 
     fileHdr->Deallocate(freeMap);  		// remove data blocks
@@ -423,7 +424,7 @@ FileSystem::Print()
 {
     FileHeader *bitHdr = new FileHeader;
     FileHeader *dirHdr = new FileHeader;
-    BitMap *freeMap = new BitMap(NumSectors);
+    BitMap *freeMap = new BitMap(volume->NumSectors());
     Directory *directory = new Directory(NumDirEntries);
 
     printf("Bit map file header:\n");
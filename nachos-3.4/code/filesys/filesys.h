@@ -69,7 +69,7 @@ class FileSystem {
 class FileSystem {
   public:
     FileSystem(bool format);		// Initialize the file system.
-					// Must be called *after* "synchDisk" 
+					// Must be called *after* "volume" 
 					// has been initialized.
     					// If "format", there is nothing on
 					// the disk, so initialize the directory
@@ -7,6 +7,10 @@
 //	   Perftest -- a stress test for the Nachos file system
 //		read and write a really large file in tiny chunks
 //		(won't work on baseline system!)
+//	   DiskSchedTest -- several threads reading scattered sectors
+//		at once, to see how well the disk scheduler does; then
+//		a batch of asynchronous reads, to check that the disk
+//		serves them in the order its policy says
 //
 // Copyright (c) 1992-1993 The Regents of the University of California.
 // All rights reserved.  See copyright.h for copyright notice and limitation 
@@ -210,3 +214,153 @@ PerformanceTest()
     stats->Print();
 }
 
+
+//----------------------------------------------------------------------
+// DiskSchedTest
+// 	Fork some threads that each read sectors scattered over the disk,
+//	straight from the disk (or volume, "-dv"), so that the disk
+//	scheduler has a queue of requests to choose from.  Print how far
+//	the heads had to move, how long requests waited, for the policy in
+//	use ("-ds"), and how long it all took.
+//
+//	Then queue a batch of reads on the first disk all at once, with
+//	ReadRequest, and check that the callbacks come back in the order
+//	the policy serves requests (see CheckPolicyOrder).
+//----------------------------------------------------------------------
+
+#define DiskTestThreads	4	// # of threads reading at once
+#define DiskTestReads	16	// # of sectors each one reads
+#define DiskTestBatch	16	// # of asynchronous reads queued at once
+
+static Semaphore *diskTestDone;
+static int batchSectors[DiskTestBatch];	// sector of each read in the batch
+static int batchOrder[DiskTestBatch];	// the reads, in the order they
+					// finished
+static int batchFinished;		// # of them finished so far
+
+static void
+DiskReader(IntPtr which)
+{
+    char data[SectorSize];
+
+    for (int i = 0; i < DiskTestReads; i++)
+	volume->ReadSector(((which * 97 + i * 389) * 7) % volume->NumSectors(),
+									data);
+    diskTestDone->V();
+}
+
+//----------------------------------------------------------------------
+// BatchReadDone
+// 	Called from the disk interrupt handler when read "which" of the
+//	batch is done.  Note the order; when the last one is in, wake up
+//	DiskSchedTest.
+//----------------------------------------------------------------------
+
+static void
+BatchReadDone(IntPtr which)
+{
+    batchOrder[batchFinished++] = (int) which;
+    if (batchFinished == DiskTestBatch)
+	diskTestDone->V();
+}
+
+//----------------------------------------------------------------------
+// CheckPolicyOrder
+// 	Check that the batch finished in an order "policy" could have
+//	served it in.  The first read went to the disk as soon as it was
+//	queued, since the disk was idle; the rest were all waiting, so:
+//
+//	FCFS serves them in the order they were queued.  C-LOOK sweeps
+//	up through the sectors, jumping back to the lowest at most once.
+//	SCAN sweeps one way and then the other, turning round at most
+//	once.  SSTF's order depends on where the disk has rotated to, so
+//	there is nothing simple to check.
+//----------------------------------------------------------------------
+
+static void
+CheckPolicyOrder(DiskPolicy policy)
+{
+    int turns = 0;
+    bool up = TRUE;
+
+    for (int i = 0; i < DiskTestBatch; i++)
+	ASSERT(policy != DiskFCFS || batchOrder[i] == i);
+    for (int i = 2; i < DiskTestBatch; i++) {
+	int from = batchSectors[batchOrder[i - 1]];
+	int to = batchSectors[batchOrder[i]];
+
+	switch (policy) {
+	  case DiskFCFS:
+	  case DiskSSTF:
+	    break;
+	  case DiskCLOOK:
+	    if (to < from)
+		turns++;
+	    break;
+	  case DiskSCAN:
+	    if (i == 2)
+		up = (to > from);
+	    else if ((to > from) != up) {
+		up = !up;
+		turns++;
+	    }
+	    break;
+	}
+    }
+    ASSERT(turns <= 1);
+}
+
+//----------------------------------------------------------------------
+// DiskBatchTest
+// 	Queue a batch of reads on the first disk of the volume, all at
+//	once, and wait for their callbacks; check they came back in
+//	policy order.  The first is in the middle of the disk, so that
+//	SCAN and C-LOOK both have to turn round.
+//----------------------------------------------------------------------
+
+static void
+DiskBatchTest()
+{
+    SynchDisk *disk = volume->Disk(0);
+    char *buffers = new char[DiskTestBatch * SectorSize];
+    IntStatus oldLevel = interrupt->SetLevel(IntOff);	// queue them all
+							// before any is done
+
+    batchFinished = 0;
+    for (int i = 0; i < DiskTestBatch; i++) {
+	batchSectors[i] = (disk->NumSectors() / 2 + i * 389 * 7)
+						% disk->NumSectors();
+	disk->ReadRequest(batchSectors[i], &buffers[i * SectorSize],
+						BatchReadDone, i);
+    }
+    (void) interrupt->SetLevel(oldLevel);
+    diskTestDone->P();
+    CheckPolicyOrder(disk->Policy());
+    printf("%d asynchronous reads done, in policy order\n", DiskTestBatch);
+    delete [] buffers;
+}
+
+void
+DiskSchedTest()
+{
+    int tracks = stats->numDiskSeekTracks;
+    int ticks = stats->diskQueueTicks;
+    int start = stats->totalTicks;
+    int reads = DiskTestThreads * DiskTestReads;
+
+    printf("Starting disk scheduler test:\n");
+    diskTestDone = new Semaphore("disk test done", 0);
+    for (int i = 0; i < DiskTestThreads; i++)
+	(new Thread("disk reader"))->Fork(DiskReader, i);
+    for (int i = 0; i < DiskTestThreads; i++)
+	diskTestDone->P();
+
+    tracks = stats->numDiskSeekTracks - tracks;
+    ticks = stats->diskQueueTicks - ticks;
+    printf("%d reads: %d tracks seeked (%d per read), %d ticks queued "
+	"(%d per read)\n", reads, tracks, tracks / reads, ticks, ticks / reads);
+    printf("%d ticks in all\n", stats->totalTicks - start);
+
+    DiskBatchTest();
+    delete diskTestDone;
+}
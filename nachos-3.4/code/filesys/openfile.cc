@@ -38,15 +38,25 @@ OpenFile::OpenFile(int sector)
     currentSector = sector;
     hdr->FetchFrom(sector);
     seekPosition = 0;
+    readAheadNext = readAheadWindow = readAheadEnd = 0;
+    writeBuffer = NULL;
+    writeSector = -1;
+    writeDatePending = FALSE;
 }
 
 //----------------------------------------------------------------------
 // OpenFile::~OpenFile
 // 	Close a Nachos file, de-allocating any in-memory data structures.
+//	Anything written that is still held here goes to the buffer
+//	cache first, and the directory gets the time of the last write.
 //----------------------------------------------------------------------
 
 OpenFile::~OpenFile()
 {
+    Flush();
+    if (writeDatePending)
+	UpdateDirectory();
+    delete [] writeBuffer;
     delete hdr;
 }
 
@@ -70,7 +80,11 @@ OpenFile::Seek(int position)
 //	Return the number of bytes actually written or read, and as a
 //	side effect, increment the current position within the file.
 //
-//	Implemented using the more primitive ReadAt/WriteAt.
+//	Implemented using the more primitive ReadAt/WriteAt.  Small
+//	writes are first held in a buffer of their own, and go on to
+//	the buffer cache a whole sector at a time (cf. BufferWrite).
+//	The directory's timestamps aren't updated on every write, but
+//	once, when the file is closed.
 //
 //	"into" -- the buffer to contain the data to be read from disk 
 //	"from" -- the buffer containing the data to be written to disk 
@@ -94,25 +108,124 @@ int
 OpenFile::Write(char *into, int numBytes)
 {
 	int result;
-   	result = WriteAt(into, numBytes, seekPosition);
+	if (BufferWrite(into, numBytes, seekPosition))
+	    result = numBytes;
+	else
+	    result = WriteAt(into, numBytes, seekPosition);
    seekPosition += result;
 	DEBUG('f', "MMMMWrited %d bytes at \n",numBytes);
    GetCurrentDate(writeDate, StringMaxLen);
    GetCurrentTime(writeTime, StringMaxLen);
    //writeTime = stats->totalTicks;
+   if (result > 0)
+	writeDatePending = TRUE;	// cf. UpdateDirectory
 
+   return result;
+}
+
+//----------------------------------------------------------------------
+// OpenFile::BufferWrite
+// 	Try to absorb a write of less than a sector into the file's own
+//	write buffer, instead of reading, changing and writing back the
+//	sector in the buffer cache each time.  Return TRUE if it was.
+//
+//	The buffer holds bytes of just one sector, and only a range of
+//	them with no gaps, so a write to another sector, or one that
+//	would leave a gap, first flushes what is there.  A write that
+//	crosses into the next sector is split in two.  Once the buffer
+//	holds the whole sector, there is nothing more to wait for, and
+//	it is flushed straight away.
+//
+//	"from" -- the buffer containing the data to be written
+//	"numBytes" -- the number of bytes to write
+//	"position" -- the offset within the file of the first byte
+//----------------------------------------------------------------------
+
+bool
+OpenFile::BufferWrite(char *from, int numBytes, int position)
+{
+    int sector = divRoundDown(position, SectorSize);
+    int offset = position - (sector * SectorSize);
+    int split = SectorSize - offset;
+
+    if ((numBytes <= 0) || (numBytes >= SectorSize)
+		|| ((position + numBytes) > hdr->FileLength()))
+	return FALSE;			// leave it to WriteAt
+    if (numBytes > split)
+	return BufferWrite(from, split, position)
+		&& BufferWrite(&from[split], numBytes - split, position + split);
+
+    if ((sector != writeSector) || (offset > writeEnd)
+		|| ((offset + numBytes) < writeStart)) {
+	Flush();
+	writeSector = sector;
+	writeStart = writeEnd = offset;
+    }
+    if (writeBuffer == NULL)
+	writeBuffer = new char[SectorSize];
+    bcopy(from, &writeBuffer[offset], numBytes);
+    writeStart = min(writeStart, offset);
+    writeEnd = max(writeEnd, offset + numBytes);
+    if ((writeStart == 0) && (writeEnd == SectorSize))
+	Flush();
+    return TRUE;
+}
+
+//----------------------------------------------------------------------
+// OpenFile::Flush
+// 	Put what the write buffer holds into the buffer cache.  If it
+//	is the whole sector, or all of it up to the end of the file,
+//	the sector is simply overwritten; if not, the bytes are copied
+//	into the sector's own cache buffer, which has the rest.
+//----------------------------------------------------------------------
+
+void
+OpenFile::Flush()
+{
+    int sector;
+    char *data;
+
+    if (writeSector == -1)
+	return;
+    DEBUG('f', "Flushing bytes %d to %d of file sector %d.\n",
+			writeStart, writeEnd, writeSector);
+    sector = hdr->ByteToSector(writeSector * SectorSize);
+    if ((writeStart == 0) && ((writeEnd == SectorSize)
+	    || ((writeSector * SectorSize + writeEnd) >= hdr->FileLength()))) {
+	bzero(&writeBuffer[writeEnd], SectorSize - writeEnd);
+	bufferCache->WriteSector(sector, writeBuffer);
+    } else {
+	data = bufferCache->Pin(sector);
+	bcopy(&writeBuffer[writeStart], &data[writeStart],
+					writeEnd - writeStart);
+	bufferCache->Unpin(sector, TRUE);
+    }
+    writeSector = -1;
+}
+
+//----------------------------------------------------------------------
+// OpenFile::UpdateDirectory
+// 	Record the time of the last write in the file's directory entry.
+//----------------------------------------------------------------------
+
+void
+OpenFile::UpdateDirectory()
+{
     Directory *directory = new Directory(12);
     char *name;
+    int index;
 
-    DEBUG('f', "Opening file %s\n", name);
     directory->FetchFrom(fileSystem->directoryFile);
     name = directory->FindName(currentSector);
-    int index = directory->FindIndex(name);
-    strncpy(directory->table[index].lastUpdateDate, directory->DirGetCurrentDate(), StringMaxLen);
-    strncpy(directory->table[index].lastUpdateTime, directory->DirGetCurrentTime(), StringMaxLen);
-    directory->WriteBack(fileSystem->directoryFile); 
-
-   return result;
+    index = (name == NULL) ? -1 : directory->FindIndex(name);
+    DEBUG('f', "Updating write time of file %s\n", name == NULL ? "?" : name);
+    if (index != -1) {
+	strncpy(directory->table[index].lastUpdateDate, writeDate, StringMaxLen);
+	strncpy(directory->table[index].lastUpdateTime, writeTime, StringMaxLen);
+	directory->WriteBack(fileSystem->directoryFile);
+    }
+    delete directory;
+    writeDatePending = FALSE;
 }
 
 int 	//Make sure that one time opening file only for one revoking this function
@@ -157,8 +270,10 @@ OpenFile::ReadAt(char *into, int numBytes, int position)
 {
     int fileLength = hdr->FileLength();
     int i, firstSector, lastSector, numSectors;
+    int sector, run;
     char *buf;
 
+    Flush();				// so that we read what was written
     if ((numBytes <= 0) || (position >= fileLength))
     	return 0; 				// check request
     if ((position + numBytes) > fileLength)		
@@ -170,19 +285,70 @@ OpenFile::ReadAt(char *into, int numBytes, int position)
     lastSector = divRoundDown(position + numBytes - 1, SectorSize);
     numSectors = 1 + lastSector - firstSector;
 
-    // read in all the full and partial sectors that we need
+    // read in all the full and partial sectors that we need, a run
+    // of sectors that are next to each other on disk at a time
     buf = new char[numSectors * SectorSize];
     //printf("Start to ReadAt from %d to %d\n",firstSector, lastSector);
-    for (i = firstSector; i <= lastSector; i++)	
-        synchDisk->ReadSector(hdr->ByteToSector(i * SectorSize), 
+    for (i = firstSector; i <= lastSector; i += run) {
+	sector = hdr->ByteToSector(i * SectorSize);
+	for (run = 1; i + run <= lastSector; run++)
+	    if (hdr->ByteToSector((i + run) * SectorSize) != sector + run)
+		break;
+        bufferCache->ReadSectors(sector, run,
 					&buf[(i - firstSector) * SectorSize]);
+    }
 
     // copy the part we want
     bcopy(&buf[position - (firstSector * SectorSize)], into, numBytes);
     delete [] buf;
+    ReadAhead(position, numBytes);
     return numBytes;
 }
 
+//----------------------------------------------------------------------
+// OpenFile::ReadAhead
+// 	Called after "numBytes" have been read at "position".  If reads
+//	of the file are sequential, start reading the sectors after them
+//	into the buffer cache in the background, so that they are there
+//	by the time they are asked for.
+//
+//	The window of sectors read ahead starts small, and doubles each
+//	time the reader catches up to half of it, up to MaxReadAhead; it
+//	goes back to nothing as soon as a read isn't sequential.
+//----------------------------------------------------------------------
+
+void
+OpenFile::ReadAhead(int position, int numBytes)
+{
+    int numFileSectors = divRoundUp(hdr->FileLength(), SectorSize);
+    int next = divRoundUp(position + numBytes, SectorSize);
+    int first, last, sector, run;
+
+    if (position != readAheadNext) {	// not sequential; start over
+	readAheadNext = position + numBytes;
+	readAheadWindow = 0;
+	readAheadEnd = next;
+	return;
+    }
+    readAheadNext = position + numBytes;
+    if (readAheadWindow == 0)
+	readAheadWindow = MinReadAhead;
+    else if (readAheadEnd - next > readAheadWindow / 2)
+	return;				// still far enough ahead
+
+    first = max(next, readAheadEnd);
+    last = min(next + readAheadWindow, numFileSectors);
+    for (int i = first; i < last; i += run) {
+	sector = hdr->ByteToSector(i * SectorSize);
+	for (run = 1; i + run < last; run++)
+	    if (hdr->ByteToSector((i + run) * SectorSize) != sector + run)
+		break;
+	bufferCache->ReadAhead(sector, run);
+    }
+    readAheadEnd = max(readAheadEnd, last);
+    readAheadWindow = min(readAheadWindow * 2, MaxReadAhead);
+}
+
 int
 OpenFile::SysCallReadAt(char *into, int numBytes, int position)
 {
@@ -190,6 +356,7 @@ OpenFile::SysCallReadAt(char *into, int numBytes, int position)
     int i, firstSector, lastSector, numSectors;
     char *buf;
 
+    Flush();
     if ((numBytes <= 0) || (position >= SectorSize))
     	return 0; 				// check request
 /*    if ((position + numBytes) > fileLength)		
@@ -204,7 +371,7 @@ OpenFile::SysCallReadAt(char *into, int numBytes, int position)
     // read in all the full and partial sectors that we need
     buf = new char[numSectors * SectorSize];
     //printf("Start to ReadAt from %d to %d\n",firstSector, lastSector);
-        synchDisk->ReadSector(hdr->ByteToSector(0), buf);
+        bufferCache->ReadSector(hdr->ByteToSector(0), buf);
 
     // copy the part we want
     bcopy(buf, into, numBytes);
@@ -219,6 +386,7 @@ OpenFile::WriteAt(char *from, int numBytes, int position)
     bool firstAligned, lastAligned;
     char *buf;
 
+    Flush();				// so as not to be overwritten by it
     if ((numBytes <= 0) || (position >= fileLength))
     {
 	return 0;				// check request
@@ -249,7 +417,7 @@ OpenFile::WriteAt(char *from, int numBytes, int position)
 
 // write modified sectors back
     for (i = firstSector; i <= lastSector; i++)	
-        synchDisk->WriteSector(hdr->ByteToSector(i * SectorSize), 
+        bufferCache->WriteSector(hdr->ByteToSector(i * SectorSize), 
 					&buf[(i - firstSector) * SectorSize]);
     delete [] buf;
     return numBytes;
@@ -298,7 +466,7 @@ DEBUG('f', "RRRRRRead '%s' from disk, start copy postion is %d, numSectors = %d,
 // write modified sectors back
 	DEBUG('f', "Sector is  %d bytes at \n",hdr->ByteToSector(0));
     DEBUG('f', "FFFFFFFFFFF\n");
-    synchDisk->WriteSector(hdr->ByteToSector(0), buf);
+    bufferCache->WriteSector(hdr->ByteToSector(0), buf);
     delete [] buf;
     return numBytes;
 }
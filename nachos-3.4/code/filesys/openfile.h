@@ -24,6 +24,9 @@
 #include "utility.h"
 
 #define StringMaxLen		12	// for strings length
+#define MinReadAhead		4	// # of sectors read ahead at first,
+#define MaxReadAhead		16	// and at most, once reads are found
+					// to be sequential
 
 #ifdef FILESYS_STUB			// Temporarily implement calls to 
 					// Nachos file system as calls to UNIX!
@@ -105,6 +108,30 @@ class OpenFile {
     FileHeader *hdr;			// Header for this file 
     int seekPosition;			// Current position within the file
     int currentSector;			// Current file header's sector on the disk --edit by YePeng
+
+    int readAheadNext;			// where a sequential read would
+					// start next
+    int readAheadWindow;		// # of sectors to read ahead; 0 if
+					// reads haven't been sequential
+    int readAheadEnd;			// sectors of the file before this
+					// have been read, or read ahead
+
+    void ReadAhead(int position, int numBytes);	// read ahead of a
+					// read that has just been done
+
+    char *writeBuffer;			// small writes to one sector of the
+					// file, not yet in the buffer cache;
+					// NULL until the first one
+    int writeSector;			// which sector of the file they are
+					// to; -1 if there are none
+    int writeStart, writeEnd;		// the bytes of the sector they cover
+    bool writeDatePending;		// written since the directory's
+					// timestamps were last updated?
+
+    bool BufferWrite(char *from, int numBytes, int position);
+					// absorb a small write, if it can be
+    void Flush();			// put the small writes into the cache
+    void UpdateDirectory();		// record writeDate/Time there
 };
 
 #endif // FILESYS
@@ -5,10 +5,12 @@
 //	the disk providing a synchronous interface (requests wait until
 //	the request completes).
 //
-//	Use a semaphore to synchronize the interrupt handlers with the
-//	pending requests.  And, because the physical disk can only
-//	handle one operation at a time, use a lock to enforce mutual
-//	exclusion.
+//	Because the physical disk can only handle one operation at a
+//	time, requests are queued, and the interrupt handler for each
+//	one that finishes starts the next.  Each request has its own
+//	semaphore (or routine to call), to let the requester know when
+//	it is done.  The queue is shared with the interrupt handler, so
+//	it is protected by turning interrupts off, not by a lock.
 //
 // Copyright (c) 1992-1993 The Regents of the University of California.
 // All rights reserved.  See copyright.h for copyright notice and limitation 
@@ -16,6 +18,8 @@
 
 #include "copyright.h"
 #include "synchdisk.h"
+#include "flash.h"
+#include "system.h"
 
 //----------------------------------------------------------------------
 // DiskRequestDone
@@ -24,7 +28,7 @@
 //----------------------------------------------------------------------
 
 static void
-DiskRequestDone (int arg)
+DiskRequestDone (IntPtr arg)
 {
     SynchDisk* disk = (SynchDisk *)arg;
 
@@ -36,15 +40,31 @@ DiskRequestDone (int arg)
 // 	Initialize the synchronous interface to the physical disk, in turn
 //	initializing the physical disk.
 //
-//	"name" -- UNIX file name to be used as storage for the disk data
+//	"diskName" -- UNIX file name to be used as storage for the disk data
 //	   (usually, "DISK")
+//	"diskPolicy" -- the order in which to serve queued requests
+//	"format" -- if not NULL, start over with a blank disk of this
+//	   geometry
+//	"mapped", "syncInterval" -- whether to map the UNIX file into
+//	   memory, and how often to sync it (cf. disk.h)
+//	"kind" -- a rotating disk, or flash memory
 //----------------------------------------------------------------------
 
-SynchDisk::SynchDisk(char* name)
+SynchDisk::SynchDisk(char* diskName, DiskPolicy diskPolicy, DiskGeometry *format,
+				bool mapped, int syncInterval, DeviceKind kind)
 {
-    semaphore = new Semaphore("synch disk", 0);
-    lock = new Lock("synch disk lock");
-    disk = new Disk(name, DiskRequestDone, (int) this);
+    name = new char[strlen(diskName) + 1];
+    strcpy(name, diskName);
+    policy = diskPolicy;
+    pending = active = NULL;
+    headSector = 0;
+    sweepingUp = TRUE;
+    if (kind == DeviceFlash)
+	disk = new Flash(diskName, DiskRequestDone, (IntPtr) this, format,
+						mapped, syncInterval);
+    else
+	disk = new Disk(diskName, DiskRequestDone, (IntPtr) this, format,
+						mapped, syncInterval);
 }
 
 //----------------------------------------------------------------------
@@ -55,9 +75,9 @@ SynchDisk::SynchDisk(char* name)
 
 SynchDisk::~SynchDisk()
 {
+    ASSERT(active == NULL && pending == NULL);
     delete disk;
-    delete lock;
-    delete semaphore;
+    delete [] name;
 }
 
 //----------------------------------------------------------------------
@@ -72,10 +92,7 @@ SynchDisk::~SynchDisk()
 void
 SynchDisk::ReadSector(int sectorNumber, char* data)
 {
-    lock->Acquire();			// only one disk I/O at a time
-    disk->ReadRequest(sectorNumber, data);
-    semaphore->P();			// wait for interrupt
-    lock->Release();
+    ReadSectors(sectorNumber, 1, &data);
 }
 
 //----------------------------------------------------------------------
@@ -90,20 +107,300 @@ SynchDisk::ReadSector(int sectorNumber, char* data)
 void
 SynchDisk::WriteSector(int sectorNumber, char* data)
 {
-    lock->Acquire();			// only one disk I/O at a time
-    disk->WriteRequest(sectorNumber, data);
-    semaphore->P();			// wait for interrupt
-    lock->Release();
+    WriteSectors(sectorNumber, 1, &data);
+}
+
+//----------------------------------------------------------------------
+// SynchDisk::ReadSectors
+// 	Read the contents of consecutive disk sectors, each into its own
+//	buffer, with one disk request.  Return only after the data has
+//	been read.
+//
+//	"sectorNumber" -- the first disk sector to read
+//	"numSectors" -- how many sectors to read
+//	"data" -- the buffers to hold the contents of the disk sectors
+//----------------------------------------------------------------------
+
+void
+SynchDisk::ReadSectors(int sectorNumber, int numSectors, char** data)
+{
+    Semaphore done("disk request", 0);
+
+    StartRequest(sectorNumber, numSectors, data, FALSE, &done);
+    done.P();				// wait for interrupt
+}
+
+//----------------------------------------------------------------------
+// SynchDisk::WriteSectors
+// 	Write the contents of several buffers into consecutive disk
+//	sectors, with one disk request.  Return only after the data has
+//	been written.
+//
+//	"sectorNumber" -- the first disk sector to be written
+//	"numSectors" -- how many sectors to write
+//	"data" -- the new contents of the disk sectors
+//----------------------------------------------------------------------
+
+void
+SynchDisk::WriteSectors(int sectorNumber, int numSectors, char** data)
+{
+    Semaphore done("disk request", 0);
+
+    StartRequest(sectorNumber, numSectors, data, TRUE, &done);
+    done.P();				// wait for interrupt
+}
+
+//----------------------------------------------------------------------
+// SynchDisk::StartRequest
+// 	Queue a request to read or write consecutive sectors, and return
+//	at once; "done" is signalled when it is finished.  "data" must
+//	stay put until then.  This lets a caller have requests out on
+//	several disks at the same time.
+//
+//	"sectorNumber" -- the first disk sector to read or write
+//	"numSectors" -- how many sectors
+//	"data" -- one buffer per sector
+//	"writing" -- write (or read)?
+//	"done" -- V'ed when the request is done
+//----------------------------------------------------------------------
+
+void
+SynchDisk::StartRequest(int sectorNumber, int numSectors, char** data,
+			bool writing, Semaphore *done)
+{
+    DiskRequest *request = new DiskRequest;
+
+    request->sector = sectorNumber;
+    request->numSectors = numSectors;
+    request->data = data;
+    request->writing = writing;
+    request->done = done;
+    Queue(request);
+}
+
+//----------------------------------------------------------------------
+// SynchDisk::QueueLength
+// 	Return the number of requests the disk has yet to finish.
+//----------------------------------------------------------------------
+
+int
+SynchDisk::QueueLength()
+{
+    IntStatus oldLevel = interrupt->SetLevel(IntOff);
+    int length = (active != NULL) ? 1 : 0;
+
+    for (DiskRequest *r = pending; r != NULL; r = r->next)
+	length++;
+    (void) interrupt->SetLevel(oldLevel);
+    return length;
+}
+
+//----------------------------------------------------------------------
+// SynchDisk::ReadRequest, WriteRequest
+// 	Queue a request to read or write a disk sector, and return at
+//	once.  "data" must stay put until the request is done, when
+//	(*callWhenDone)(callArg) is called, from the interrupt handler.
+//----------------------------------------------------------------------
+
+void
+SynchDisk::ReadRequest(int sectorNumber, char* data,
+			VoidFunctionPtr callWhenDone, IntPtr callArg)
+{
+    DiskRequest *request = new DiskRequest;
+
+    request->sector = sectorNumber;
+    request->numSectors = 1;
+    request->buffer = data;
+    request->data = &request->buffer;
+    request->writing = FALSE;
+    request->done = NULL;
+    request->callWhenDone = callWhenDone;
+    request->callArg = callArg;
+    Queue(request);
+}
+
+void
+SynchDisk::WriteRequest(int sectorNumber, char* data,
+			VoidFunctionPtr callWhenDone, IntPtr callArg)
+{
+    DiskRequest *request = new DiskRequest;
+
+    request->sector = sectorNumber;
+    request->numSectors = 1;
+    request->buffer = data;
+    request->data = &request->buffer;
+    request->writing = TRUE;
+    request->done = NULL;
+    request->callWhenDone = callWhenDone;
+    request->callArg = callArg;
+    Queue(request);
+}
+
+//----------------------------------------------------------------------
+// SynchDisk::Queue
+// 	Add a request to the end of the queue, and if the disk has
+//	nothing to do, start on it straight away.  Every request comes
+//	through here, so this is where its sectors are charged to the
+//	thread making it, and to its address space.
+//----------------------------------------------------------------------
+
+void
+SynchDisk::Queue(DiskRequest *request)
+{
+    DiskRequest **last;
+    IntStatus oldLevel = interrupt->SetLevel(IntOff);
+
+    ASSERT(request->sector >= 0
+		&& request->sector + request->numSectors <= disk->NumSectors());
+    if (request->writing) {
+	currentThread->usage.numDiskWrites += request->numSectors;
+#ifdef USER_PROGRAM
+	if (currentThread->space != NULL)
+	    currentThread->space->usage.numDiskWrites += request->numSectors;
+#endif
+    } else {
+	currentThread->usage.numDiskReads += request->numSectors;
+#ifdef USER_PROGRAM
+	if (currentThread->space != NULL)
+	    currentThread->space->usage.numDiskReads += request->numSectors;
+#endif
+    }
+    request->arrival = stats->totalTicks;
+    request->requester = currentThread->getName();
+    request->next = NULL;
+    for (last = &pending; *last != NULL; last = &(*last)->next)
+	;
+    *last = request;
+    if (active == NULL)
+	StartNext();
+    (void) interrupt->SetLevel(oldLevel);
+}
+
+//----------------------------------------------------------------------
+// SynchDisk::ChooseNext
+// 	Take the request to serve next off the queue, according to the
+//	scheduling policy; ties go to the one that has waited longest.
+//	Called with interrupts off, and with at least one request queued.
+//
+//	FCFS takes the oldest request.  SSTF takes the one the disk can
+//	get to soonest, seek and rotation included.  SCAN takes the
+//	nearest one in the direction the head is sweeping, turning round
+//	when there are none left that way.  C-LOOK takes the nearest one
+//	at or above the head, and when there are none, jumps back to the
+//	lowest.
+//----------------------------------------------------------------------
+
+DiskRequest *
+SynchDisk::ChooseNext()
+{
+    DiskRequest **best = &pending;
+    DiskRequest **r;
+    DiskRequest *chosen;
+
+    switch (policy) {
+      case DiskFCFS:
+	break;
+
+      case DiskSSTF: {
+	int bestTime = disk->ComputeLatency((*best)->sector, (*best)->writing);
+	for (r = &(*best)->next; *r != NULL; r = &(*r)->next) {
+	    int time = disk->ComputeLatency((*r)->sector, (*r)->writing);
+	    if (time < bestTime) {
+		best = r;
+		bestTime = time;
+	    }
+	}
+	break;
+      }
+
+      case DiskSCAN:
+	best = Nearest(headSector, sweepingUp);
+	if (best == NULL) {			// nothing ahead; turn round
+	    sweepingUp = !sweepingUp;
+	    best = Nearest(headSector, sweepingUp);
+	}
+	break;
+
+      case DiskCLOOK:
+	best = Nearest(headSector, TRUE);
+	if (best == NULL)			// nothing ahead; jump back
+	    best = Nearest(0, TRUE);
+	break;
+    }
+
+    chosen = *best;
+    *best = chosen->next;
+    return chosen;
+}
+
+//----------------------------------------------------------------------
+// SynchDisk::Nearest
+// 	Return (the link to) the queued request nearest to "sector",
+//	going up from it if "up" is TRUE, down from it if not; NULL
+//	if there are none that way.
+//----------------------------------------------------------------------
+
+DiskRequest **
+SynchDisk::Nearest(int sector, bool up)
+{
+    DiskRequest **best = NULL;
+    DiskRequest **r;
+
+    for (r = &pending; *r != NULL; r = &(*r)->next) {
+	if (up ? (*r)->sector < sector : (*r)->sector > sector)
+	    continue;
+	if (best == NULL || (up ? (*r)->sector < (*best)->sector
+				: (*r)->sector > (*best)->sector))
+	    best = r;
+    }
+    return best;
+}
+
+//----------------------------------------------------------------------
+// SynchDisk::StartNext
+// 	If any requests are waiting, send the next one to the disk.
+//	Called with interrupts off, when the disk is idle.
+//----------------------------------------------------------------------
+
+void
+SynchDisk::StartNext()
+{
+    ASSERT(active == NULL);
+    if (pending == NULL)
+	return;
+
+    active = ChooseNext();
+    stats->diskQueueTicks += stats->totalTicks - active->arrival;
+    DEBUG('d', "Disk scheduler: sector %d, head at %d\n",
+					active->sector, headSector);
+    headSector = active->sector + active->numSectors - 1;
+    if (active->writing)
+	disk->WritevRequest(active->sector, active->data, active->numSectors);
+    else
+	disk->ReadvRequest(active->sector, active->data, active->numSectors);
+    active->started = stats->totalTicks;
+    active->latency = *disk->Latency();
+    stats->numDiskSeekTracks += active->latency.seekTracks;
 }
 
 //----------------------------------------------------------------------
 // SynchDisk::RequestDone
-// 	Disk interrupt handler.  Wake up any thread waiting for the disk
-//	request to finish.
+// 	Disk interrupt handler.  Let the requester know that its request
+//	is finished, and start on the next one.
 //----------------------------------------------------------------------
 
 void
 SynchDisk::RequestDone()
 { 
-    semaphore->V();
+    DiskRequest *request = active;
+
+    if (diskTracer != NULL)
+	diskTracer->Record(name, request);
+    active = NULL;
+    StartNext();
+    if (request->done != NULL)
+	request->done->V();
+    else
+	(*request->callWhenDone)(request->callArg);
+    delete request;
 }
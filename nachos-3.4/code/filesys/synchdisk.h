@@ -14,6 +14,37 @@
 #include "disk.h"
 #include "synch.h"
 
+// The order in which pending requests are sent to the disk.
+
+enum DiskPolicy {
+    DiskFCFS,		// first come, first served
+    DiskSSTF,		// shortest (seek + rotation) time first
+    DiskSCAN,		// elevator: sweep up, then down, then up...
+    DiskCLOOK		// sweep up only, then jump back to the lowest
+};
+
+// The following class defines one request waiting for the disk.
+// Internal to SynchDisk; kept public so that its operations can
+// access it directly.
+
+class DiskRequest {
+  public:
+    int sector;			// which sector (the first, if several)
+    int numSectors;		// how many consecutive sectors
+    char **data;		// where the data goes, or comes from,
+				// one buffer per sector
+    char *buffer;		// "data", for a one-sector request
+    bool writing;		// write (or read)?
+    int arrival;		// when the request was made
+    int started;		// when the disk started on it
+    DiskLatency latency;	// and how long it took the disk
+    char *requester;		// name of the thread that made it
+    Semaphore *done;		// signalled when it's done, if not NULL;
+    VoidFunctionPtr callWhenDone;	// otherwise, this is called
+    IntPtr callArg;
+    DiskRequest *next;		// next request, in order of arrival
+};
+
 // The following class defines a "synchronous" disk abstraction.
 // As with other I/O devices, the raw physical disk is an asynchronous device --
 // requests to read or write portions of the disk return immediately,
@@ -24,30 +55,77 @@
 // This class provides the abstraction that for any individual thread
 // making a request, it waits around until the operation finishes before
 // returning.
+//
+// Underneath, requests from all threads are queued, and whenever the
+// disk finishes one, the next is chosen according to the scheduling
+// policy, so that the head doesn't have to swing back and forth.
+// A request can also be made asynchronously, to have a routine
+// called when it is done instead of waiting for it.
 class SynchDisk {
   public:
-    SynchDisk(char* name);    		// Initialize a synchronous disk,
-					// by initializing the raw Disk.
+    SynchDisk(char* name, DiskPolicy policy = DiskCLOOK,
+		DiskGeometry *format = NULL, bool mapped = FALSE,
+		int syncInterval = 0, DeviceKind kind = DeviceDisk);
+    					// Initialize a synchronous disk,
+					// by initializing the raw Disk (or
+					// other kind of device).
     ~SynchDisk();			// De-allocate the synch disk data
     
     void ReadSector(int sectorNumber, char* data);
     					// Read/write a disk sector, returning
     					// only once the data is actually read 
-					// or written.  These call
-    					// Disk::ReadRequest/WriteRequest and
-					// then wait until the request is done.
+					// or written.  These queue a request
+					// and then wait until it is done.
     void WriteSector(int sectorNumber, char* data);
+
+    void ReadSectors(int sectorNumber, int numSectors, char** data);
+    void WriteSectors(int sectorNumber, int numSectors, char** data);
+    					// Read/write consecutive sectors,
+					// each to/from its own buffer, as
+					// one disk request.
+    void StartRequest(int sectorNumber, int numSectors, char** data,
+		bool writing, Semaphore *done);
+    					// Likewise, but return at once;
+					// "done" is V'ed when it is done.
+
+    void ReadRequest(int sectorNumber, char* data,
+		VoidFunctionPtr callWhenDone, IntPtr callArg);
+    					// Read/write a disk sector, returning
+					// at once; (*callWhenDone)(callArg)
+					// is called from the disk interrupt
+					// handler when it is done, so it
+					// must not block.
+    void WriteRequest(int sectorNumber, char* data,
+		VoidFunctionPtr callWhenDone, IntPtr callArg);
     
+    int NumSectors() { return disk->NumSectors(); }
+					// # of sectors on the disk
+    int QueueLength();			// # of requests not yet done
+    int HeadSector() { return headSector; }	// where the head is
+					// (or is going to)
+    DiskPolicy Policy() { return policy; }	// order requests are
+					// served in
+
     void RequestDone();			// Called by the disk device interrupt
 					// handler, to signal that the
 					// current disk operation is complete.
 
   private:
-    Disk *disk;		  		// Raw disk device
-    Semaphore *semaphore; 		// To synchronize requesting thread 
-					// with the interrupt handler
-    Lock *lock;		  		// Only one read/write request
-					// can be sent to the disk at a time
+    char *name;				// the UNIX file, for tracing
+    StorageDevice *disk;		// Raw disk device
+    DiskPolicy policy;			// how to choose the next request
+    DiskRequest *pending;		// requests waiting for the disk,
+					// oldest first
+    DiskRequest *active;		// the request the disk is doing now
+    int headSector;			// where the last request left the head
+    bool sweepingUp;			// direction of the SCAN sweep
+
+    void Queue(DiskRequest *request);	// add a request, and start it
+					// if the disk is idle
+    void StartNext();			// send the next request to the disk
+    DiskRequest *ChooseNext();		// pick it, by the policy
+    DiskRequest **Nearest(int sector, bool up);	// nearest request
+					// to "sector", going up or down
 };
 
 #endif // SYNCHDISK_H
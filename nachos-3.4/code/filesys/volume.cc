@@ -0,0 +1,211 @@
+// volume.cc
+//	Routines to spread the sectors of a logical volume over several
+//	disks, striped or mirrored (cf. volume.h).
+//
+//	A request to the volume is turned into at most one request per
+//	disk, all of which are queued before waiting for any of them, so
+//	that the disks transfer their parts at the same time.
+//
+// Copyright (c) 1992-1993 The Regents of the University of California.
+// All rights reserved.  See copyright.h for copyright notice and limitation
+// of liability and disclaimer of warranty provisions.
+
+#include "copyright.h"
+#include "volume.h"
+#include "system.h"
+
+//----------------------------------------------------------------------
+// Volume::Volume
+// 	Initialize a volume, by initializing each of its disks.  The
+//	first disk is stored in the UNIX file "DISK", as when there is
+//	only one; the others in "DISK1", "DISK2", and so on.
+//
+//	"layout" -- striped or mirrored
+//	"count" -- the number of disks
+//	"policy", "format", "mapped", "syncInterval", "kind" -- for each
+//	   disk (cf. SynchDisk)
+//----------------------------------------------------------------------
+
+Volume::Volume(VolumeLayout volumeLayout, int count, DiskPolicy policy,
+		DiskGeometry *format, bool mapped, int syncInterval,
+		DeviceKind kind)
+{
+    char name[32];
+    int diskSectors;
+
+    ASSERT(count >= 1 && count <= MaxVolumeDisks);
+    layout = volumeLayout;
+    numDisks = count;
+    for (int i = 0; i < numDisks; i++) {
+	if (i == 0)
+	    strcpy(name, "DISK");
+	else
+	    sprintf(name, "DISK%d", i);
+	disks[i] = new SynchDisk(name, policy, format, mapped, syncInterval,
+									kind);
+	ASSERT(disks[i]->NumSectors() == disks[0]->NumSectors());
+    }
+
+    diskSectors = disks[0]->NumSectors();
+    if (numDisks == 1 || layout == VolumeMirrored)
+	numSectors = diskSectors;
+    else	// only whole stripes
+	numSectors = numDisks * (diskSectors / StripeSectors) * StripeSectors;
+    DEBUG('d', "Volume of %d sectors, %s over %d disks\n", numSectors,
+	(layout == VolumeMirrored) ? "mirrored" : "striped", numDisks);
+}
+
+//----------------------------------------------------------------------
+// Volume::~Volume
+// 	De-allocate the volume, and its disks.
+//----------------------------------------------------------------------
+
+Volume::~Volume()
+{
+    for (int i = 0; i < numDisks; i++)
+	delete disks[i];
+}
+
+//----------------------------------------------------------------------
+// Volume::ReadSector/WriteSector/ReadSectors/WriteSectors
+// 	Read or write one sector, or consecutive sectors, of the volume.
+//	Return only once the data has been read or written.
+//
+//	"sectorNumber" -- the (first) sector of the volume
+//	"count" -- how many sectors
+//	"data" -- the buffer(s) to hold the contents of the sector(s)
+//----------------------------------------------------------------------
+
+void
+Volume::ReadSector(int sectorNumber, char* data)
+{
+    Transfer(sectorNumber, 1, &data, FALSE);
+}
+
+void
+Volume::WriteSector(int sectorNumber, char* data)
+{
+    Transfer(sectorNumber, 1, &data, TRUE);
+}
+
+void
+Volume::ReadSectors(int sectorNumber, int count, char** data)
+{
+    Transfer(sectorNumber, count, data, FALSE);
+}
+
+void
+Volume::WriteSectors(int sectorNumber, int count, char** data)
+{
+    Transfer(sectorNumber, count, data, TRUE);
+}
+
+//----------------------------------------------------------------------
+// Volume::Transfer
+// 	Read or write consecutive sectors of the volume, with one request
+//	to each disk involved, and wait for all of them.
+//
+//	Mirrored, a write goes to every disk, a read to just one.
+//	Striped, the sectors on any one disk are always consecutive
+//	there too -- each disk gets every numDisks'th stripe, and they
+//	are stored one after another -- so a disk's share is a single
+//	request.
+//----------------------------------------------------------------------
+
+void
+Volume::Transfer(int sectorNumber, int count, char** data, bool writing)
+{
+    Semaphore done("volume request", 0);
+    int numRequests = 0;
+    char **share[MaxVolumeDisks];	// each disk's part of "data",
+    int first[MaxVolumeDisks];		// where it starts on the disk,
+    int length[MaxVolumeDisks];		// and how many sectors it is
+    int disk, diskSector;
+
+    ASSERT(sectorNumber >= 0 && sectorNumber + count <= numSectors);
+    for (int i = 0; i < numDisks; i++)
+	length[i] = 0;
+
+    if (numDisks == 1) {
+	disks[0]->StartRequest(sectorNumber, count, data, writing, &done);
+	numRequests = 1;
+    } else if (layout == VolumeMirrored) {
+	if (writing) {
+	    for (int i = 0; i < numDisks; i++)
+		disks[i]->StartRequest(sectorNumber, count, data, TRUE, &done);
+	    numRequests = numDisks;
+	} else {
+	    disks[ChooseReplica(sectorNumber)]->StartRequest(sectorNumber,
+						count, data, FALSE, &done);
+	    numRequests = 1;
+	}
+    } else {
+	for (int i = 0; i < count; i++) {
+	    Locate(sectorNumber + i, &disk, &diskSector);
+	    if (length[disk] == 0) {
+		share[disk] = new char*[count];
+		first[disk] = diskSector;
+	    }
+	    ASSERT(diskSector == first[disk] + length[disk]);
+	    share[disk][length[disk]++] = data[i];
+	}
+	for (int i = 0; i < numDisks; i++)
+	    if (length[i] > 0) {
+		disks[i]->StartRequest(first[i], length[i], share[i], writing,
+									&done);
+		numRequests++;
+	    }
+    }
+
+    for (int i = 0; i < numRequests; i++)	// wait for them all
+	done.P();
+    for (int i = 0; i < numDisks; i++)
+	if (length[i] > 0)
+	    delete [] share[i];
+}
+
+//----------------------------------------------------------------------
+// Volume::Locate
+// 	Find which disk a sector of a striped volume is on, and where.
+//	Stripe s of the volume is stripe s / numDisks of disk
+//	s % numDisks.
+//----------------------------------------------------------------------
+
+void
+Volume::Locate(int sectorNumber, int *disk, int *diskSector)
+{
+    int stripe = sectorNumber / StripeSectors;
+
+    *disk = stripe % numDisks;
+    *diskSector = (stripe / numDisks) * StripeSectors
+					+ sectorNumber % StripeSectors;
+}
+
+//----------------------------------------------------------------------
+// Volume::ChooseReplica
+// 	Return which disk of a mirrored volume to read "sectorNumber"
+//	from: the one with the fewest requests still to do, and of
+//	those, the one whose head is nearest to the sector.
+//----------------------------------------------------------------------
+
+int
+Volume::ChooseReplica(int sectorNumber)
+{
+    int best = 0;
+    int bestLength = disks[0]->QueueLength();
+    int bestDistance = abs(disks[0]->HeadSector() - sectorNumber);
+
+    for (int i = 1; i < numDisks; i++) {
+	int length = disks[i]->QueueLength();
+	int distance = abs(disks[i]->HeadSector() - sectorNumber);
+
+	if (length < bestLength
+		|| (length == bestLength && distance < bestDistance)) {
+	    best = i;
+	    bestLength = length;
+	    bestDistance = distance;
+	}
+    }
+    DEBUG('d', "Reading sector %d from mirror %d\n", sectorNumber, best);
+    return best;
+}
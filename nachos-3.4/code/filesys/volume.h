@@ -0,0 +1,80 @@
+// volume.h
+//	Data structures for a logical volume, made out of one or more
+//	simulated disks, for the file system to sit on.
+//
+//	The disks of a volume can be used two ways.  Striped (RAID-0),
+//	the volume's sectors are dealt out to the disks a few at a time
+//	in turn, so that a run of sectors is read or written by all of
+//	them at once.  Mirrored (RAID-1), every disk holds a copy of the
+//	whole volume: a write goes to all of them, and a read to
+//	whichever one is least busy.  A volume of one disk is just that
+//	disk.
+//
+//	Each disk is a SynchDisk of its own, with its own queue of
+//	requests, and its own head; the disks all work at the same time.
+//	The volume's layout isn't recorded on the disks, so it must be
+//	given the same way every time.
+//
+// Copyright (c) 1992-1993 The Regents of the University of California.
+// All rights reserved.  See copyright.h for copyright notice and limitation
+// of liability and disclaimer of warranty provisions.
+
+#ifndef VOLUME_H
+#define VOLUME_H
+
+#include "copyright.h"
+#include "disk.h"
+#include "synchdisk.h"
+
+#define MaxVolumeDisks	8		// most disks in a volume
+#define StripeSectors	4		// # of consecutive sectors of a
+					// striped volume on each disk in turn
+
+// How the sectors of a volume are laid out on its disks.
+
+enum VolumeLayout {
+    VolumeStriped,		// RAID-0: spread over the disks
+    VolumeMirrored		// RAID-1: a copy on each disk
+};
+
+// The following class defines a logical volume.  It has the same
+// interface as a SynchDisk; requests that involve several disks are
+// sent to all of them before waiting for any.
+
+class Volume {
+  public:
+    Volume(VolumeLayout layout, int numDisks, DiskPolicy policy = DiskCLOOK,
+		DiskGeometry *format = NULL, bool mapped = FALSE,
+		int syncInterval = 0, DeviceKind kind = DeviceDisk);
+					// Initialize a volume, on disks
+					// "DISK", "DISK1", "DISK2", ...
+					// (the other arguments as for
+					// SynchDisk)
+    ~Volume();				// De-allocate the volume, and its disks
+
+    void ReadSector(int sectorNumber, char* data);
+    void WriteSector(int sectorNumber, char* data);
+    void ReadSectors(int sectorNumber, int numSectors, char** data);
+    void WriteSectors(int sectorNumber, int numSectors, char** data);
+					// Read/write sectors of the volume,
+					// returning once they are done
+
+    int NumSectors() { return numSectors; }	// # of sectors in the volume
+    SynchDisk *Disk(int which) { return disks[which]; }	// one of the
+					// disks, to use directly
+
+  private:
+    VolumeLayout layout;
+    int numDisks;
+    SynchDisk *disks[MaxVolumeDisks];	// the disks it is made of
+    int numSectors;			// # of sectors in the volume
+
+    void Transfer(int sectorNumber, int numSectors, char** data,
+		bool writing);		// read/write, on as many disks
+					// as it takes
+    void Locate(int sectorNumber, int *disk, int *diskSector);
+					// where a striped sector lives
+    int ChooseReplica(int sectorNumber);	// mirror to read from
+};
+
+#endif // VOLUME_H
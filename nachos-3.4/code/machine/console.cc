@@ -18,9 +18,9 @@
 #include "system.h"
 
 // Dummy functions because C++ is weird about pointers to member functions
-static void ConsoleReadPoll(int c) 
+static void ConsoleReadPoll(IntPtr c) 
 { Console *console = (Console *)c; console->CheckCharAvail(); }
-static void ConsoleWriteDone(int c)
+static void ConsoleWriteDone(IntPtr c)
 { Console *console = (Console *)c; console->WriteDone(); }
 
 //----------------------------------------------------------------------
@@ -37,7 +37,7 @@ static void ConsoleWriteDone(int c)
 //----------------------------------------------------------------------
 
 Console::Console(char *readFile, char *writeFile, VoidFunctionPtr readAvail, 
-		VoidFunctionPtr writeDone, int callArg)
+		VoidFunctionPtr writeDone, IntPtr callArg)
 {
     if (readFile == NULL)
 	readFileNo = 0;					// keyboard = stdin
@@ -56,7 +56,7 @@ Console::Console(char *readFile, char *writeFile, VoidFunctionPtr readAvail,
     incoming = EOF;
 
     // start polling for incoming packets
-    interrupt->Schedule(ConsoleReadPoll, (int)this, ConsoleTime, ConsoleReadInt);
+    interrupt->Schedule(ConsoleReadPoll, (IntPtr) this, ConsoleTime, ConsoleReadInt);
 }
 
 //----------------------------------------------------------------------
@@ -89,15 +89,25 @@ Console::CheckCharAvail()
     char c;
 
     // schedule the next time to poll for a packet
-    interrupt->Schedule(ConsoleReadPoll, (int)this, ConsoleTime, 
+    interrupt->Schedule(ConsoleReadPoll, (IntPtr) this, ConsoleTime, 
 			ConsoleReadInt);
 
-    // do nothing if character is already buffered, or none to be read
-    if ((incoming != EOF) || !PollFile(readFileNo))
-	return;	  
-
-    // otherwise, read character and tell user about it
-    Read(readFileNo, &c, sizeof(char));
+    // do nothing if character is already buffered
+    if (incoming != EOF)
+	return;
+
+    // otherwise, read character (if one has been typed, or was typed
+    // at this point in the run being replayed), and tell user about it
+    if (eventLog != NULL && eventLog->IsReplaying()) {
+	if (eventLog->ReplayInput(&c, sizeof(char)) == 0)
+	    return;
+    } else {
+	if (!PollFile(readFileNo))
+	    return;
+	Read(readFileNo, &c, sizeof(char));
+	if (eventLog != NULL)
+	    eventLog->RecordInput(&c, sizeof(char));
+    }
     incoming = c ;
     stats->numConsoleCharsRead++;
     (*readHandler)(handlerArg);	
@@ -145,7 +155,7 @@ Console::PutChar(char ch)
     ASSERT(putBusy == FALSE);
     WriteFile(writeFileNo, &ch, sizeof(char));
     putBusy = TRUE;
-    interrupt->Schedule(ConsoleWriteDone, (int)this, ConsoleTime,
+    interrupt->Schedule(ConsoleWriteDone, (IntPtr) this, ConsoleTime,
 					ConsoleWriteInt);
 }
 
@@ -156,8 +166,8 @@ Console::PutChar(char ch)
 static Semaphore *readAvail;
 static Semaphore *writeDone;
 
-static void ReadAvail(int arg) { DEBUG('a', "ReadAvail:readAvail->V()\n"); readAvail->V(); }
-static void WriteDone(int arg) { DEBUG('a', "WriteDone:writeDone->V()\n"); writeDone->V(); }
+static void ReadAvail(IntPtr arg) { DEBUG('a', "ReadAvail:readAvail->V()\n"); readAvail->V(); }
+static void WriteDone(IntPtr arg) { DEBUG('a', "WriteDone:writeDone->V()\n"); writeDone->V(); }
 
 SynchConsole::SynchConsole(char *readFile, char *writeFile, int callArg)
 {
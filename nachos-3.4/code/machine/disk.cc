@@ -7,6 +7,13 @@
 //	Disk operations are asynchronous, so we have to invoke an interrupt
 //	handler when the simulated operation completes.
 //
+//	If asked, the UNIX file is mapped into memory instead, and sectors
+//	are simply copied in and out of it.
+//
+//	Keeping the sectors in the UNIX file is common to all storage
+//	devices (StorageDevice); how long requests take is particular to
+//	the rotating disk (Disk), and is worked out here too.
+//
 //  DO NOT CHANGE -- part of the machine emulation
 //
 // Copyright (c) 1992-1993 The Regents of the University of California.
@@ -19,28 +26,39 @@
 
 // We put this at the front of the UNIX file representing the
 // disk, to make it less likely we will accidentally treat a useful file 
-// as a disk (which would probably trash the file's contents).
-#define MagicNumber 	0x456789ab
+// as a disk (which would probably trash the file's contents).  It is
+// followed by the superblock, recording the disk's geometry.  (Disks
+// made before there was a superblock have the old magic number, and
+// the default geometry.)
+#define MagicNumber 	0x456789ac
+#define OldMagicNumber 	0x456789ab
 #define MagicSize 	sizeof(int)
 
-#define DiskSize 	(MagicSize + (NumSectors * SectorSize))
+#define DiskSize 	(headerSize + (totalSectors * SectorSize))
 
 // dummy procedure because we can't take a pointer of a member function
-static void DiskDone(int arg) { ((Disk *)arg)->HandleInterrupt(); }
+static void DiskDone(IntPtr arg) { ((StorageDevice *)arg)->HandleInterrupt(); }
 
 //----------------------------------------------------------------------
-// Disk::Disk()
-// 	Initialize a simulated disk.  Open the UNIX file (creating it
-//	if it doesn't exist), and check the magic number to make sure it's 
-// 	ok to treat it as Nachos disk storage.
+// StorageDevice::StorageDevice()
+// 	Initialize a simulated storage device.  Open the UNIX file
+//	(creating it if it doesn't exist), and check the magic number to
+//	make sure it's ok to treat it as Nachos disk storage.
 //
 //	"name" -- text name of the file simulating the Nachos disk
 //	"callWhenDone" -- interrupt handler to be called when disk read/write
 //	   request completes
 //	"callArg" -- argument to pass the interrupt handler
+//	"format" -- if not NULL, (re-)create the UNIX file, as a blank
+//	   disk of this geometry
+//	"mapped" -- map the UNIX file into memory, rather than reading
+//	   and writing it
+//	"interval" -- when mapped, sync the file after this many write
+//	   requests (0: only when the disk is deleted)
 //----------------------------------------------------------------------
 
-Disk::Disk(char* name, VoidFunctionPtr callWhenDone, int callArg)
+StorageDevice::StorageDevice(char* name, VoidFunctionPtr callWhenDone,
+		IntPtr callArg, DiskGeometry *format, bool mapped, int interval)
 {
     int magicNum;
     int tmp = 0;
@@ -48,33 +66,79 @@ Disk::Disk(char* name, VoidFunctionPtr callWhenDone, int callArg)
     DEBUG('d', "Initializing the disk, 0x%x 0x%x\n", callWhenDone, callArg);
     handler = callWhenDone;
     handlerArg = callArg;
-    lastSector = 0;
-    bufferInit = 0;
     
-    fileno = OpenForReadWrite(name, FALSE);
+    geometry.sectorSize = SectorSize;
+    geometry.sectorsPerTrack = DefaultSectorsPerTrack;
+    geometry.numTracks = DefaultNumTracks;
+    headerSize = MagicSize + sizeof(DiskGeometry);
+
+    fileno = (format == NULL) ? OpenForReadWrite(name, FALSE) : -1;
     if (fileno >= 0) {		 	// file exists, check magic number 
 	Read(fileno, (char *) &magicNum, MagicSize);
-	ASSERT(magicNum == MagicNumber);
+	if (magicNum == OldMagicNumber)
+	    headerSize = MagicSize;
+	else {
+	    ASSERT(magicNum == MagicNumber);
+	    Read(fileno, (char *) &geometry, sizeof(DiskGeometry));
+	    if (geometry.sectorSize != SectorSize) {
+		printf("Disk %s has %d-byte sectors, but Nachos was built "
+			"for %d; reformat it\n", name, geometry.sectorSize,
+			SectorSize);
+		ASSERT(FALSE);
+	    }
+	}
+	totalSectors = geometry.sectorsPerTrack * geometry.numTracks;
     } else {				// file doesn't exist, create it
+	if (format != NULL) {
+	    ASSERT(format->sectorSize == SectorSize);
+	    ASSERT(format->sectorsPerTrack > 0 && format->numTracks > 0);
+	    geometry = *format;
+	}
+	totalSectors = geometry.sectorsPerTrack * geometry.numTracks;
         fileno = OpenForWrite(name);
 	magicNum = MagicNumber;  
 	WriteFile(fileno, (char *) &magicNum, MagicSize); // write magic number
+	WriteFile(fileno, (char *) &geometry, sizeof(DiskGeometry));
 
 	// need to write at end of file, so that reads will not return EOF
         Lseek(fileno, DiskSize - sizeof(int), 0);	
 	WriteFile(fileno, (char *)&tmp, sizeof(int));  
     }
     active = FALSE;
+    DEBUG('d', "Disk has %d tracks of %d sectors of %d bytes\n",
+	geometry.numTracks, geometry.sectorsPerTrack, geometry.sectorSize);
+
+    image = mapped ? MapFile(fileno, DiskSize) : NULL;
+    syncInterval = interval;
+    writesSinceSync = 0;
 }
 
 //----------------------------------------------------------------------
-// Disk::~Disk()
+// Disk::Disk()
+// 	Initialize a simulated rotating disk, with the head at sector 0.
+//	(The arguments are as for StorageDevice.)
+//----------------------------------------------------------------------
+
+Disk::Disk(char* name, VoidFunctionPtr callWhenDone, IntPtr callArg,
+		DiskGeometry *format, bool mapped, int interval)
+	: StorageDevice(name, callWhenDone, callArg, format, mapped, interval)
+{
+    lastSector = 0;
+    bufferInit = 0;
+}
+
+//----------------------------------------------------------------------
+// StorageDevice::~StorageDevice()
 // 	Clean up disk simulation, by closing the UNIX file representing the
 //	disk.
 //----------------------------------------------------------------------
 
-Disk::~Disk()
+StorageDevice::~StorageDevice()
 {
+    if (image != NULL) {
+	SyncMappedFile(image, DiskSize);
+	UnmapFile(image, DiskSize);
+    }
     Close(fileno);
 }
 
@@ -98,7 +162,7 @@ PrintSector (bool writing, int sector, char *data)
 }
 
 //----------------------------------------------------------------------
-// Disk::ReadRequest/WriteRequest
+// StorageDevice::ReadRequest/WriteRequest
 // 	Simulate a request to read/write a single disk sector
 //	   Do the read/write immediately to the UNIX file
 //	   Set up an interrupt handler to be called later,
@@ -113,53 +177,100 @@ PrintSector (bool writing, int sector, char *data)
 //----------------------------------------------------------------------
 
 void
-Disk::ReadRequest(int sectorNumber, char* data)
+StorageDevice::ReadRequest(int sectorNumber, char* data)
 {
-    int ticks = ComputeLatency(sectorNumber, FALSE);
+    ReadvRequest(sectorNumber, &data, 1);
+}
+
+void
+StorageDevice::WriteRequest(int sectorNumber, char* data)
+{
+    WritevRequest(sectorNumber, &data, 1);
+}
+
+//----------------------------------------------------------------------
+// StorageDevice::ReadvRequest/WritevRequest
+// 	Simulate a request to read/write a run of consecutive disk
+//	sectors, each to/from its own buffer.  As for a single sector,
+//	the read/write is done immediately to the UNIX file (in one
+//	system call), and an interrupt is scheduled for when the
+//	simulated disk would have finished.
+//
+//	"sectorNumber" -- the first disk sector to read/write
+//	"data" -- the buffers, one per sector
+//	"numSectors" -- how many sectors
+//----------------------------------------------------------------------
+
+void
+StorageDevice::ReadvRequest(int sectorNumber, char** data, int numSectors)
+{
+    int lastSectorNumber = sectorNumber + numSectors - 1;
+    int ticks;
 
     ASSERT(!active);				// only one request at a time
-    ASSERT((sectorNumber >= 0) && (sectorNumber < NumSectors));
+    ASSERT((sectorNumber >= 0) && (lastSectorNumber < totalSectors));
+    ASSERT((numSectors > 0) && (numSectors <= MaxSectorsPerRequest));
+    ticks = Start(sectorNumber, numSectors, FALSE);
     
-    DEBUG('d', "Reading from sector %d\n", sectorNumber);
-    Lseek(fileno, SectorSize * sectorNumber + MagicSize, 0);
-    Read(fileno, data, SectorSize);
+    DEBUG('d', "Reading from sectors %d to %d\n", sectorNumber,
+							lastSectorNumber);
+    if (image != NULL)
+	for (int i = 0; i < numSectors; i++)
+	    bcopy(&image[SectorSize * (sectorNumber + i) + headerSize],
+						data[i], SectorSize);
+    else
+	ReadVector(fileno, data, numSectors, SectorSize,
+					SectorSize * sectorNumber + headerSize);
     if (DebugIsEnabled('d'))
-	PrintSector(FALSE, sectorNumber, data);
+	for (int i = 0; i < numSectors; i++)
+	    PrintSector(FALSE, sectorNumber + i, data[i]);
     
     active = TRUE;
-    UpdateLast(sectorNumber);
     stats->numDiskReads++;
-    interrupt->Schedule(DiskDone, (int) this, ticks, DiskInt);
+    interrupt->Schedule(DiskDone, (IntPtr) this, ticks, DiskInt);
 }
 
 void
-Disk::WriteRequest(int sectorNumber, char* data)
+StorageDevice::WritevRequest(int sectorNumber, char** data, int numSectors)
 {
-    int ticks = ComputeLatency(sectorNumber, TRUE);
+    int lastSectorNumber = sectorNumber + numSectors - 1;
+    int ticks;
 
     ASSERT(!active);
-    ASSERT((sectorNumber >= 0) && (sectorNumber < NumSectors));
+    ASSERT((sectorNumber >= 0) && (lastSectorNumber < totalSectors));
+    ASSERT((numSectors > 0) && (numSectors <= MaxSectorsPerRequest));
+    ticks = Start(sectorNumber, numSectors, TRUE);
     
-    DEBUG('d', "Writing to sector %d\n", sectorNumber);
-    Lseek(fileno, SectorSize * sectorNumber + MagicSize, 0);
-    WriteFile(fileno, data, SectorSize);
+    DEBUG('d', "Writing to sectors %d to %d\n", sectorNumber,
+							lastSectorNumber);
+    if (image != NULL) {
+	for (int i = 0; i < numSectors; i++)
+	    bcopy(data[i], &image[SectorSize * (sectorNumber + i) + headerSize],
+								SectorSize);
+	if (syncInterval > 0 && ++writesSinceSync == syncInterval) {
+	    SyncMappedFile(image, DiskSize);	// checkpoint
+	    writesSinceSync = 0;
+	}
+    } else
+	WriteVector(fileno, data, numSectors, SectorSize,
+					SectorSize * sectorNumber + headerSize);
     if (DebugIsEnabled('d'))
-	PrintSector(TRUE, sectorNumber, data);
+	for (int i = 0; i < numSectors; i++)
+	    PrintSector(TRUE, sectorNumber + i, data[i]);
     
     active = TRUE;
-    UpdateLast(sectorNumber);
     stats->numDiskWrites++;
-    interrupt->Schedule(DiskDone, (int) this, ticks, DiskInt);
+    interrupt->Schedule(DiskDone, (IntPtr) this, ticks, DiskInt);
 }
 
 //----------------------------------------------------------------------
-// Disk::HandleInterrupt()
+// StorageDevice::HandleInterrupt()
 // 	Called when it is time to invoke the disk interrupt handler,
 //	to tell the Nachos kernel that the disk request is done.
 //----------------------------------------------------------------------
 
 void
-Disk::HandleInterrupt ()
+StorageDevice::HandleInterrupt ()
 { 
     active = FALSE;
     (*handler)(handlerArg);
@@ -179,8 +290,8 @@ Disk::HandleInterrupt ()
 int
 Disk::TimeToSeek(int newSector, int *rotation) 
 {
-    int newTrack = newSector / SectorsPerTrack;
-    int oldTrack = lastSector / SectorsPerTrack;
+    int newTrack = newSector / geometry.sectorsPerTrack;
+    int oldTrack = lastSector / geometry.sectorsPerTrack;
     int seek = abs(newTrack - oldTrack) * SeekTime;
 				// how long will seek take?
     int over = (stats->totalTicks + seek) % RotationTime; 
@@ -202,10 +313,11 @@ Disk::TimeToSeek(int newSector, int *rotation)
 int 
 Disk::ModuloDiff(int to, int from)
 {
-    int toOffset = to % SectorsPerTrack;
-    int fromOffset = from % SectorsPerTrack;
+    int perTrack = geometry.sectorsPerTrack;
+    int toOffset = to % perTrack;
+    int fromOffset = from % perTrack;
 
-    return ((toOffset - fromOffset) + SectorsPerTrack) % SectorsPerTrack;
+    return ((toOffset - fromOffset) + perTrack) % perTrack;
 }
 
 //----------------------------------------------------------------------
@@ -227,29 +339,69 @@ Disk::ModuloDiff(int to, int from)
 //   	read requests to the current track to be satisfied more quickly.
 //   	The contents of the track buffer are discarded after every seek to 
 //   	a new track.
+//
+//	A request for "numSectors" consecutive sectors pays for getting
+//	to the first one, as above, and then one more transfer time for
+//	each of the rest, plus a one-track seek wherever the run goes on
+//	to the next track.
+//
+//	If "parts" isn't NULL, it is filled in with how the time is made
+//	up; the transfer includes all that comes after the first sector
+//	is reached.
 //----------------------------------------------------------------------
 
 int
-Disk::ComputeLatency(int newSector, bool writing)
+Disk::ComputeLatency(int newSector, bool writing, int numSectors,
+			DiskLatency *parts)
 {
     int rotation;
     int seek = TimeToSeek(newSector, &rotation);
     int timeAfter = stats->totalTicks + seek + rotation;
+    int rest = (numSectors - 1) * RotationTime
+	+ ((newSector + numSectors - 1) / geometry.sectorsPerTrack
+			- newSector / geometry.sectorsPerTrack) * SeekTime;
+
+    if (parts != NULL) {
+	parts->seekTracks = seek / SeekTime;
+	parts->seek = seek;
+	parts->transfer = RotationTime + rest;
+    }
 
 #ifndef NOTRACKBUF	// turn this on if you don't want the track buffer stuff
     // check if track buffer applies
     if ((writing == FALSE) && (seek == 0) 
 		&& (((timeAfter - bufferInit) / RotationTime) 
 	     		> ModuloDiff(newSector, bufferInit / RotationTime))) {
-        DEBUG('d', "Request latency = %d\n", RotationTime);
-	return RotationTime; // time to transfer sector from the track buffer
+        DEBUG('d', "Request latency = %d\n", RotationTime + rest);
+	if (parts != NULL)
+	    parts->rotation = 0;
+	return RotationTime + rest; // time to transfer sector from the
+				    // track buffer, then the rest
     }
 #endif
 
     rotation += ModuloDiff(newSector, timeAfter / RotationTime) * RotationTime;
+    if (parts != NULL)
+	parts->rotation = rotation;
+
+    DEBUG('d', "Request latency = %d\n", seek + rotation + RotationTime + rest);
+    return(seek + rotation + RotationTime + rest);
+}
+
+//----------------------------------------------------------------------
+// Disk::Start
+// 	A request for "numSectors" sectors from "sectorNumber" is
+//	starting now: return how long it will take, and move the head
+//	to the end of it.
+//----------------------------------------------------------------------
+
+int
+Disk::Start(int sectorNumber, int numSectors, bool writing)
+{
+    int ticks = ComputeLatency(sectorNumber, writing, numSectors, &latency);
 
-    DEBUG('d', "Request latency = %d\n", seek + rotation + RotationTime);
-    return(seek + rotation + RotationTime);
+    UpdateLast(sectorNumber + numSectors - 1);
+    return ticks;
 }
 
 //----------------------------------------------------------------------
@@ -26,7 +26,13 @@
 // sector has the same number of bytes of storage).  
 //
 // Addressing is by sector number -- each sector on the disk is given
-// a unique number: track * SectorsPerTrack + offset within a track.
+// a unique number: track * sectorsPerTrack + offset within a track.
+//
+// The number of tracks, and of sectors per track, is chosen when the
+// disk is created (formatted), and recorded in a "superblock" at the
+// front of the UNIX file, along with the sector size; the sector size
+// itself is fixed when Nachos is compiled, since it is also the page
+// size (build with -DSectorSize=512, say, to change it).
 //
 // As with other I/O devices, the raw physical disk is an asynchronous device --
 // requests to read or write portions of the disk return immediately,
@@ -45,20 +51,72 @@
 // disks these days now come with a track buffer.
 //
 // The track buffer simulation can be disabled by compiling with -DNOTRACKBUF
+//
+// The UNIX file can also be mapped into memory, so that sectors are
+// moved with bcopy instead of system calls; changes are synced out to
+// the file every so many write requests, and when the disk is deleted.
+// Only the host's cost changes -- the simulated time does not.
 
+#ifndef SectorSize
 #define SectorSize 		128	// number of bytes per disk sector
-#define SectorsPerTrack 	32	// number of sectors per disk track 
-#define NumTracks 		32	// number of tracks per disk
-#define NumSectors 		(SectorsPerTrack * NumTracks)
-					// total # of sectors per disk
+#endif
+#define DefaultSectorsPerTrack 	32	// number of sectors per disk track,
+#define DefaultNumTracks 	32	// and of tracks per disk, unless
+					// the disk is formatted otherwise
+#define MaxSectorsPerRequest	32	// most sectors moved by one request
+
+// The following class defines the shape of a disk; it is what is kept
+// in the superblock.
 
-class Disk {
+class DiskGeometry {
   public:
-    Disk(char* name, VoidFunctionPtr callWhenDone, int callArg);
-    					// Create a simulated disk.  
+    int sectorSize;			// # of bytes per sector
+    int sectorsPerTrack;		// # of sectors per track
+    int numTracks;			// # of tracks
+};
+
+// The following class defines where the time for a disk request
+// goes, for tracing.  Devices without a head just wait, and transfer.
+
+class DiskLatency {
+  public:
+    int seekTracks;			// # of tracks the head moved
+    int seek;				// ticks spent seeking
+    int rotation;			// ticks waiting for the first sector
+					// to come round (or for the device
+					// to be free to start on it)
+    int transfer;			// ticks moving the data (and going on
+					// to the next track, for long runs)
+};
+
+// The kinds of storage device there are.
+
+enum DeviceKind {
+    DeviceDisk,			// the rotating disk described above
+    DeviceFlash			// flash memory (cf. flash.h)
+};
+
+// The following class defines what all storage devices have in
+// common: sectors kept in a UNIX file, with a superblock in front,
+// and requests that return at once and interrupt when they are done.
+// How long a request takes is up to each kind of device, which
+// supplies Start and ComputeLatency.
+
+class StorageDevice {
+  public:
+    StorageDevice(char* name, VoidFunctionPtr callWhenDone, IntPtr callArg,
+		DiskGeometry *format = NULL, bool mapped = FALSE,
+		int syncInterval = 0);
+    					// Create a simulated device.  
 					// Invoke (*callWhenDone)(callArg) 
 					// every time a request completes.
-    ~Disk();				// Deallocate the disk.
+					// If "format" isn't NULL, start
+					// over with a blank device that size.
+					// If "mapped", map the UNIX file
+					// into memory, and sync it every
+					// "syncInterval" writes (0: never,
+					// until the device is deleted).
+    virtual ~StorageDevice();		// Deallocate the device.
     
     void ReadRequest(int sectorNumber, char* data);
     					// Read/write an single disk sector.
@@ -67,20 +125,73 @@ class Disk {
     					// Only one request allowed at a time!
     void WriteRequest(int sectorNumber, char* data);
 
+    void ReadvRequest(int sectorNumber, char** data, int numSectors);
+    					// Read/write "numSectors" consecutive
+					// sectors, starting at sectorNumber,
+					// to/from separate buffers, as one
+					// request.
+    void WritevRequest(int sectorNumber, char** data, int numSectors);
+
     void HandleInterrupt();		// Interrupt handler, invoked when
 					// disk request finishes.
 
-    int ComputeLatency(int newSector, bool writing);	
+    virtual int ComputeLatency(int newSector, bool writing,
+		int numSectors = 1, DiskLatency *parts = NULL) = 0;
     					// Return how long a request to 
-					// newSector will take: 
-					// (seek + rotational delay + transfer)
+					// newSector would take now, and if
+					// "parts", how long each part is
+    DiskLatency *Latency() { return &latency; }	// the time for the
+					// request most recently started
+
+    int NumSectors() { return totalSectors; }	// # of sectors on the disk
+    int SectorsPerTrack() { return geometry.sectorsPerTrack; }
+
+  protected:
+    DiskGeometry geometry;		// the shape of the disk
+    int totalSectors;			// # of sectors on it
+    DiskLatency latency;		// of the latest request
+
+    virtual int Start(int sectorNumber, int numSectors, bool writing) = 0;
+					// a request is starting now: return
+					// how long it will take, fill in
+					// "latency", and update the state
+					// of the device to match
 
   private:
     int fileno;				// UNIX file number for simulated disk 
+    int headerSize;			// # of bytes in front of sector 0
+    char *image;			// the UNIX file, mapped into memory;
+					// NULL if it isn't
+    int syncInterval;			// # of writes between syncs of "image"
+    int writesSinceSync;
     VoidFunctionPtr handler;		// Interrupt handler, to be invoked 
 					// when any disk request finishes
-    int handlerArg;			// Argument to interrupt handler 
+    IntPtr handlerArg;		// Argument to interrupt handler 
     bool active;     			// Is a disk operation in progress?
+};
+
+// The following class defines the rotating disk described at the top
+// of this file.  A request for a run of sectors is one seek, then one
+// transfer after another.
+
+class Disk : public StorageDevice {
+  public:
+    Disk(char* name, VoidFunctionPtr callWhenDone, IntPtr callArg,
+		DiskGeometry *format = NULL, bool mapped = FALSE,
+		int syncInterval = 0);
+    					// Create a simulated disk.  
+
+    int ComputeLatency(int newSector, bool writing, int numSectors = 1,
+		DiskLatency *parts = NULL);
+    					// Return how long a request to 
+					// newSector will take: 
+					// (seek + rotational delay + transfer)
+					// and if "parts", how long each is
+
+  protected:
+    int Start(int sectorNumber, int numSectors, bool writing);
+
+  private:
     int lastSector;			// The previous disk request 
     int bufferInit;			// When the track buffer started 
 					// being loaded
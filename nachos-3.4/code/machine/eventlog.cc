@@ -0,0 +1,174 @@
+// eventlog.cc
+//	Routines to record the interrupts delivered during a run of Nachos,
+//	and to replay them.
+//
+//	When recording, an interrupt isn't written out until the next one
+//	is delivered (or the log is closed), since the input its handler
+//	reads goes on the same line.  Lines with input are flushed out
+//	straight away, so that a crash doesn't lose them.
+//
+//	When replaying, the line for an interrupt is read in as it is
+//	delivered, so that the input is there for its handler to ask for.
+//
+// Copyright (c) 1992-1993 The Regents of the University of California.
+// All rights reserved.  See copyright.h for copyright notice and limitation
+// of liability and disclaimer of warranty provisions.
+
+#include "copyright.h"
+#include "eventlog.h"
+#include "system.h"
+
+//----------------------------------------------------------------------
+// EventLog::EventLog
+// 	Open a log of interrupts.
+//
+//	"fileName" is the UNIX file holding the log.
+//	"replay" is TRUE to replay a log recorded earlier, FALSE to
+//		record a new one (overwriting the file if it exists).
+//----------------------------------------------------------------------
+
+EventLog::EventLog(char *fileName, bool replay)
+{
+    file = fopen(fileName, replay ? "r" : "w");
+    if (file == NULL) {
+	printf("Unable to open event log %s\n", fileName);
+	ASSERT(FALSE);
+    }
+    replaying = replay;
+    done = FALSE;
+    numEvents = 0;
+    inputLength = 0;
+    unwritten = FALSE;
+}
+
+//----------------------------------------------------------------------
+// EventLog::~EventLog
+// 	Write out the last interrupt, if we are recording, and close
+//	the log.
+//----------------------------------------------------------------------
+
+EventLog::~EventLog()
+{
+    if (unwritten)
+	WriteEvent();
+    fclose(file);
+}
+
+//----------------------------------------------------------------------
+// EventLog::Deliver
+// 	Called by the interrupt simulation as it is about to call the
+//	handler for an interrupt of kind "t", due at time "w".
+//
+//	When recording, log it.  When replaying, read in the logged
+//	interrupt, which had better be the same one.  Once a replay has
+//	run out of log, do nothing: the log was opened for reading, so
+//	there is nowhere to record to.
+//----------------------------------------------------------------------
+
+void
+EventLog::Deliver(IntType t, int w)
+{
+    if (done)
+	return;
+    numEvents++;
+    if (!replaying) {
+	if (unwritten)
+	    WriteEvent();
+	type = t;
+	when = w;
+	inputLength = 0;
+	unwritten = TRUE;
+	return;
+    }
+
+    if (!ReadEvent()) {
+	printf("Event log ran out after %d interrupts, at time %d; "
+		"carrying on live\n", numEvents - 1, w);
+	replaying = FALSE;
+	done = TRUE;
+	return;
+    }
+    if (type != t || when != w) {
+	printf("Replay diverged at interrupt %d: logged type %d at time %d, "
+		"but got type %d at time %d\n", numEvents, type, when, t, w);
+	fflush(stdout);
+	ASSERT(FALSE);
+    }
+}
+
+//----------------------------------------------------------------------
+// EventLog::RecordInput
+// 	When recording, note that the handler for the current interrupt
+//	read "length" bytes of "data" from the outside world.
+//----------------------------------------------------------------------
+
+void
+EventLog::RecordInput(char *data, int length)
+{
+    if (replaying || done || !unwritten)	// not recording
+	return;
+    ASSERT(inputLength + length <= MaxEventInput);
+    bcopy(data, &input[inputLength], length);
+    inputLength += length;
+}
+
+//----------------------------------------------------------------------
+// EventLog::ReplayInput
+// 	When replaying, copy the input the handler for the current
+//	interrupt read when it was recorded into "data" (up to
+//	"maxLength" bytes).  Return the number of bytes, 0 if there
+//	wasn't any input.
+//----------------------------------------------------------------------
+
+int
+EventLog::ReplayInput(char *data, int maxLength)
+{
+    int length = inputLength;
+
+    ASSERT(replaying && length <= maxLength);
+    bcopy(input, data, length);
+    inputLength = 0;			// it's been read
+    return length;
+}
+
+//----------------------------------------------------------------------
+// EventLog::WriteEvent
+// 	Write out the current interrupt, and the input read by its
+//	handler, as one line of the log.
+//----------------------------------------------------------------------
+
+void
+EventLog::WriteEvent()
+{
+    fprintf(file, "%d %d %d ", when, (int) type, inputLength);
+    for (int i = 0; i < inputLength; i++)
+	fprintf(file, "%02x", (unsigned char) input[i]);
+    fprintf(file, "\n");
+    if (inputLength > 0)		// don't lose input if we crash; the
+	fflush(file);			// rest can be worked out again
+    unwritten = FALSE;
+}
+
+//----------------------------------------------------------------------
+// EventLog::ReadEvent
+// 	Read the next interrupt, and the input read by its handler, from
+//	the log.  Return FALSE if there are no more.
+//----------------------------------------------------------------------
+
+bool
+EventLog::ReadEvent()
+{
+    int t;
+    unsigned int byte;
+
+    if (fscanf(file, "%d %d %d", &when, &t, &inputLength) != 3)
+	return FALSE;
+    type = (IntType) t;
+    ASSERT(inputLength >= 0 && inputLength <= MaxEventInput);
+    for (int i = 0; i < inputLength; i++) {
+	if (fscanf(file, "%2x", &byte) != 1)
+	    return FALSE;
+	input[i] = (char) byte;
+    }
+    return TRUE;
+}
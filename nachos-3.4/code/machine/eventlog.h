@@ -0,0 +1,74 @@
+// eventlog.h
+//	Data structures to record, and later replay, the hardware
+//	interrupts delivered during a run of Nachos.
+//
+//	Given the same random seed ("-rs"), everything Nachos does is
+//	determined by simulated time -- except for input from the outside
+//	world: when a character is typed at the console, or a packet
+//	arrives from another Nachos, and what it contains.
+//
+//	In record mode ("-rec <file>"), every interrupt delivered is
+//	logged, with its type and when it fired, along with any input
+//	the device read while handling it.  In replay mode ("-rep <file>"),
+//	the console and network take their input from the log instead of
+//	from UNIX, so the run can be repeated exactly; each interrupt
+//	delivered is checked against the log, to catch a replay that has
+//	gone off the rails.  When the log runs out, the run carries on
+//	live, and nothing more is logged.
+//
+//	The log is a text file, one line per interrupt:
+//
+//		<when> <type> <# bytes of input> <input, in hex>
+//
+// Copyright (c) 1992-1993 The Regents of the University of California.
+// All rights reserved.  See copyright.h for copyright notice and limitation
+// of liability and disclaimer of warranty provisions.
+
+#ifndef EVENTLOG_H
+#define EVENTLOG_H
+
+#include "copyright.h"
+#include "interrupt.h"
+#include <stdio.h>
+
+#define MaxEventInput	128		// most input read in one interrupt
+
+// The following class defines an interrupt log, being either written
+// (record mode) or read back (replay mode).
+
+class EventLog {
+  public:
+    EventLog(char *fileName, bool replay);	// open a log to record
+					// to, or to replay from
+    ~EventLog();			// finish the log, and close it
+
+    bool IsReplaying() { return replaying; }	// input comes from
+					// the log, not from UNIX?
+
+    void Deliver(IntType type, int when);	// an interrupt is about
+					// to be handled
+    void RecordInput(char *data, int length);	// the handler for the
+					// current interrupt read "data"
+    int ReplayInput(char *data, int maxLength);	// return the input read
+					// by the handler for the current
+					// interrupt, when it was recorded
+
+  private:
+    FILE *file;				// the log
+    bool replaying;			// replaying (or recording)?
+    bool done;				// replayed the whole log, so
+					// neither replaying nor recording?
+    int numEvents;			// # of interrupts so far
+
+    IntType type;			// the interrupt being handled
+    int when;
+    char input[MaxEventInput];		// input read while handling it
+    int inputLength;			// # of bytes of "input"
+    bool unwritten;			// recorded but not yet written out?
+
+    void WriteEvent();			// write out the current interrupt
+    bool ReadEvent();			// read in the next one; FALSE if
+					// the log has run out
+};
+
+#endif // EVENTLOG_H
@@ -0,0 +1,246 @@
+// flash.cc
+//	Routines to simulate a flash memory device, with a page-mapped
+//	flash translation layer and greedy garbage collection.  See
+//	flash.h for how the device behaves.
+//
+//	Block b is on channel b % FlashChannels; page p is page
+//	p % FlashPagesPerBlock of block p / FlashPagesPerBlock.
+//
+// Copyright (c) 1992-1993 The Regents of the University of California.
+// All rights reserved.  See copyright.h for copyright notice and limitation
+// of liability and disclaimer of warranty provisions.
+
+#include "copyright.h"
+#include "flash.h"
+#include "system.h"
+
+//----------------------------------------------------------------------
+// Flash::Flash
+// 	Initialize a simulated flash device, storing its sectors in the
+//	UNIX file "name" as a disk would.  Every block starts out erased,
+//	and no sector is mapped to a page yet.
+//----------------------------------------------------------------------
+
+Flash::Flash(char* name, VoidFunctionPtr callWhenDone, IntPtr callArg,
+		DiskGeometry *format, bool mapped, int interval)
+	: StorageDevice(name, callWhenDone, callArg, format, mapped, interval)
+{
+    int blocksPerChannel = divRoundUp(divRoundUp(totalSectors, FlashChannels),
+				FlashPagesPerBlock) + FlashSpareBlocks;
+    int numPages;
+
+    numBlocks = blocksPerChannel * FlashChannels;
+    numPages = numBlocks * FlashPagesPerBlock;
+    pageMap = new int[totalSectors];
+    pageOwner = new int[numPages];
+    validPages = new int[numBlocks];
+    nextPage = new int[numBlocks];
+    for (int i = 0; i < totalSectors; i++)
+	pageMap[i] = -1;
+    for (int i = 0; i < numPages; i++)
+	pageOwner[i] = -1;
+    for (int i = 0; i < numBlocks; i++)
+	validPages[i] = nextPage[i] = 0;
+    for (int c = 0; c < FlashChannels; c++) {
+	openBlock[c] = c;
+	numErased[c] = blocksPerChannel - 1;
+    }
+    DEBUG('d', "Flash has %d blocks of %d pages, on %d channels\n",
+	numBlocks, FlashPagesPerBlock, FlashChannels);
+}
+
+//----------------------------------------------------------------------
+// Flash::~Flash
+// 	De-allocate the flash translation layer.
+//----------------------------------------------------------------------
+
+Flash::~Flash()
+{
+    delete [] pageMap;
+    delete [] pageOwner;
+    delete [] validPages;
+    delete [] nextPage;
+}
+
+//----------------------------------------------------------------------
+// Flash::ComputeLatency
+// 	Return how long a request for "numSectors" sectors from
+//	"newSector" would take: each channel reads or programs its
+//	share of the pages, one after another, and the channels all
+//	work at once.  Garbage collection can make a write take longer,
+//	but whether it will is not known until the write is done.
+//
+//	If "parts" isn't NULL, it is filled in; it is all transfer.
+//----------------------------------------------------------------------
+
+int
+Flash::ComputeLatency(int newSector, bool writing, int numSectors,
+			DiskLatency *parts)
+{
+    int pages[FlashChannels];
+    int busiest = 0;
+    int ticks;
+
+    for (int c = 0; c < FlashChannels; c++)
+	pages[c] = 0;
+    for (int i = 0; i < numSectors; i++)
+	pages[(newSector + i) % FlashChannels]++;
+    for (int c = 0; c < FlashChannels; c++)
+	busiest = max(busiest, pages[c]);
+    ticks = busiest * (writing ? FlashProgramTime : FlashReadTime);
+
+    if (parts != NULL) {
+	parts->seekTracks = parts->seek = parts->rotation = 0;
+	parts->transfer = ticks;
+    }
+    DEBUG('d', "Request latency = %d\n", ticks);
+    return ticks;
+}
+
+//----------------------------------------------------------------------
+// Flash::Start
+// 	A request for "numSectors" sectors from "sectorNumber" is
+//	starting now.  For a write, give each sector a fresh page,
+//	collecting garbage where needed.  Return how long the busiest
+//	channel takes; any time beyond the plain transfer is counted as
+//	waiting, in "latency".
+//----------------------------------------------------------------------
+
+int
+Flash::Start(int sectorNumber, int numSectors, bool writing)
+{
+    int busy[FlashChannels];
+    int ticks = 0;
+
+    for (int c = 0; c < FlashChannels; c++)
+	busy[c] = 0;
+    for (int i = 0; i < numSectors; i++) {
+	int sector = sectorNumber + i;
+	int channel = sector % FlashChannels;
+
+	busy[channel] += writing ? Program(sector, channel) : FlashReadTime;
+    }
+    for (int c = 0; c < FlashChannels; c++)
+	ticks = max(ticks, busy[c]);
+
+    ComputeLatency(sectorNumber, writing, numSectors, &latency);
+    latency.rotation = ticks - latency.transfer;
+    return ticks;
+}
+
+//----------------------------------------------------------------------
+// Flash::Program
+// 	Write "sector" to a fresh page on "channel", and invalidate the
+//	page it was in before, if any.  Return how long it took,
+//	including any garbage collection needed to find the page.
+//----------------------------------------------------------------------
+
+int
+Flash::Program(int sector, int channel)
+{
+    int old = pageMap[sector];
+    int ticks = 0;
+    int page;
+
+    if (old != -1) {
+	pageOwner[old] = -1;
+	validPages[old / FlashPagesPerBlock]--;
+    }
+    page = NextFreePage(channel, &ticks);
+    pageMap[sector] = page;
+    pageOwner[page] = sector;
+    validPages[page / FlashPagesPerBlock]++;
+    stats->numFlashPrograms++;
+    return ticks + FlashProgramTime;
+}
+
+//----------------------------------------------------------------------
+// Flash::NextFreePage
+// 	Return the next erased page of the block being filled on
+//	"channel".  If that block is full, start on an erased one --
+//	first collecting garbage until there are more erased blocks than
+//	the reserve, and adding the time that took to "*ticks".  (The
+//	pages moved may have started on one already.)
+//----------------------------------------------------------------------
+
+int
+Flash::NextFreePage(int channel, int *ticks)
+{
+    int block = openBlock[channel];
+
+    if (nextPage[block] == FlashPagesPerBlock) {
+	while (numErased[channel] <= FlashReserveBlocks)
+	    *ticks += Collect(channel);
+	block = openBlock[channel];	// collecting may have started one
+	if (nextPage[block] == FlashPagesPerBlock)
+	    block = openBlock[channel] = TakeErasedBlock(channel);
+    }
+    return block * FlashPagesPerBlock + nextPage[block]++;
+}
+
+//----------------------------------------------------------------------
+// Flash::TakeErasedBlock
+// 	Return an erased block on "channel", and count it as no longer
+//	erased.  There must be one.
+//----------------------------------------------------------------------
+
+int
+Flash::TakeErasedBlock(int channel)
+{
+    for (int b = channel; b < numBlocks; b += FlashChannels)
+	if (nextPage[b] == 0 && b != openBlock[channel]) {
+	    numErased[channel]--;
+	    return b;
+	}
+    ASSERT(FALSE);
+    return -1;
+}
+
+//----------------------------------------------------------------------
+// Flash::Collect
+// 	Garbage collect the full block on "channel" with the fewest
+//	valid pages: move each of them to a fresh page (a read and a
+//	program; the reserve of erased blocks guarantees there is
+//	room), then erase the block.  Return how long it took.
+//
+//	There are enough spare blocks that some full block always has
+//	an invalid page, so every collection frees at least one page.
+//----------------------------------------------------------------------
+
+int
+Flash::Collect(int channel)
+{
+    int victim = -1;
+    int ticks = 0;
+    int block, dest;
+
+    for (int b = channel; b < numBlocks; b += FlashChannels)
+	if (nextPage[b] == FlashPagesPerBlock && b != openBlock[channel]
+		&& (victim == -1 || validPages[b] < validPages[victim]))
+	    victim = b;
+    ASSERT(victim != -1 && validPages[victim] < FlashPagesPerBlock);
+    DEBUG('d', "Flash collecting block %d, with %d valid pages\n", victim,
+						validPages[victim]);
+
+    for (int p = victim * FlashPagesPerBlock;
+			p < (victim + 1) * FlashPagesPerBlock; p++) {
+	if (pageOwner[p] == -1)
+	    continue;
+	block = openBlock[channel];
+	if (nextPage[block] == FlashPagesPerBlock)
+	    block = openBlock[channel] = TakeErasedBlock(channel);
+	dest = block * FlashPagesPerBlock + nextPage[block]++;
+	pageOwner[dest] = pageOwner[p];
+	pageMap[pageOwner[p]] = dest;
+	validPages[block]++;
+	pageOwner[p] = -1;
+	ticks += FlashReadTime + FlashProgramTime;
+	stats->numFlashPrograms++;
+	stats->numFlashMoves++;
+    }
+    validPages[victim] = 0;
+    nextPage[victim] = 0;			// erase it
+    numErased[channel]++;
+    stats->numFlashErases++;
+    return ticks + FlashEraseTime;
+}
@@ -0,0 +1,84 @@
+// flash.h
+//	Data structures to emulate a flash memory device (an SSD), as an
+//	alternative to the rotating disk.
+//
+//	Flash is read and written ("programmed") a page at a time, here
+//	one sector, but a page can only be programmed once; before it can
+//	be written again, the whole block it is in must be erased.  So
+//	the device has a "flash translation layer" (FTL): each sector
+//	written goes to a fresh page, and a map says which page holds
+//	each sector now.  The old page is left behind, invalid.  When a
+//	channel is running out of erased blocks, garbage collection picks
+//	the block with the fewest valid pages, moves those pages to fresh
+//	ones, and erases it.
+//
+//	The pages are spread over several channels, which work at the
+//	same time; sector s is always kept on channel s % FlashChannels,
+//	so a run of sectors is read or written by all of the channels at
+//	once.  There is no seek or rotational delay: a request takes as
+//	long as its busiest channel, including any garbage collection.
+//
+//	As for the disk, the sectors themselves are kept in a UNIX file
+//	(cf. disk.h); only the time taken is simulated.  The FTL's map is
+//	kept in memory, so each time Nachos starts, the device starts
+//	out freshly erased.
+//
+// Copyright (c) 1992-1993 The Regents of the University of California.
+// All rights reserved.  See copyright.h for copyright notice and limitation
+// of liability and disclaimer of warranty provisions.
+
+#ifndef FLASH_H
+#define FLASH_H
+
+#include "copyright.h"
+#include "disk.h"
+
+#define FlashChannels		4	// # of channels working at once
+#define FlashPagesPerBlock	32	// # of pages erased together
+#define FlashSpareBlocks	3	// # of blocks per channel beyond
+					// what its sectors need
+#define FlashReserveBlocks	1	// erased blocks kept back on each
+					// channel, for garbage collection
+
+// The following class defines a flash memory device.
+
+class Flash : public StorageDevice {
+  public:
+    Flash(char* name, VoidFunctionPtr callWhenDone, IntPtr callArg,
+		DiskGeometry *format = NULL, bool mapped = FALSE,
+		int syncInterval = 0);
+    					// Create a simulated flash device
+					// (the arguments are as for a disk)
+    ~Flash();				// Deallocate it.
+
+    int ComputeLatency(int newSector, bool writing, int numSectors = 1,
+		DiskLatency *parts = NULL);
+    					// Return how long a request would
+					// take, if no garbage collection
+					// were needed
+
+  protected:
+    int Start(int sectorNumber, int numSectors, bool writing);
+
+  private:
+    int numBlocks;			// # of blocks, on all channels
+    int *pageMap;			// page holding each sector; -1 if
+					// the sector hasn't been written
+    int *pageOwner;			// sector in each page; -1 if the
+					// page is erased, or invalid
+    int *validPages;			// # of valid pages in each block
+    int *nextPage;			// # of pages programmed in each
+					// block; 0 if it is erased
+    int openBlock[FlashChannels];	// block being filled on each channel
+    int numErased[FlashChannels];	// # of erased blocks on each channel
+
+    int Program(int sector, int channel);	// write a sector to a
+					// fresh page; return how long it took
+    int NextFreePage(int channel, int *ticks);	// a fresh page to write
+					// on "channel"; may collect garbage
+    int TakeErasedBlock(int channel);	// an erased block, to fill
+    int Collect(int channel);		// garbage collect one block;
+					// return how long it took
+};
+
+#endif // FLASH_H
@@ -28,7 +28,7 @@
 
 static char *intLevelNames[] = { "off", "on"};
 static char *intTypeNames[] = { "timer", "disk", "console write", 
-			"console read", "network send", "network recv"};
+			"console read", "network send", "network recv", "alarm"};
 
 //----------------------------------------------------------------------
 // PendingInterrupt::PendingInterrupt
@@ -41,7 +41,7 @@ static char *intTypeNames[] = { "timer", "disk", "console write",
 //	"kind" is the hardware device that generated the interrupt
 //----------------------------------------------------------------------
 
-PendingInterrupt::PendingInterrupt(VoidFunctionPtr func, int param, int time, 
+PendingInterrupt::PendingInterrupt(VoidFunctionPtr func, IntPtr param, int time, 
 				IntType kind)
 {
     handler = func;
@@ -60,7 +60,7 @@ PendingInterrupt::PendingInterrupt(VoidFunctionPtr func, int param, int time,
 Interrupt::Interrupt()
 {
     level = IntOff;
-    pending = new List();
+    pending = new Heap();
     inHandler = FALSE;
     yieldOnReturn = FALSE;
     status = SystemMode;
@@ -74,7 +74,7 @@ Interrupt::Interrupt()
 Interrupt::~Interrupt()
 {
     while (!pending->IsEmpty())
-	delete (PendingInterrupt *)pending->Remove();
+	delete (PendingInterrupt *)pending->RemoveMin(NULL);
     delete pending;
 }
 
@@ -156,9 +156,18 @@ Interrupt::OneTick()
     if (status == SystemMode) {
         stats->totalTicks += SystemTick;
 	stats->systemTicks += SystemTick;
+	currentThread->usage.systemTicks += SystemTick;
+#ifdef USER_PROGRAM
+	if (currentThread->space != NULL)
+	    currentThread->space->usage.systemTicks += SystemTick;
+#endif
     } else {					// USER_PROGRAM
 	stats->totalTicks += UserTick;
 	stats->userTicks += UserTick;
+	currentThread->usage.userTicks += UserTick;
+#ifdef USER_PROGRAM
+	currentThread->space->usage.userTicks += UserTick;
+#endif
     }
     DEBUG('i', "\n== Tick %d ==\n", stats->totalTicks);
 
@@ -242,6 +251,12 @@ Interrupt::Halt()
 {
     printf("Machine halting!\n\n");
     stats->Print();
+    if (schedTracer != NULL)
+	schedTracer->Print();
+#ifdef FILESYS
+    if (diskTracer != NULL)
+	diskTracer->Print();
+#endif
     Cleanup();     // Never returns.
 }
 
@@ -262,7 +277,7 @@ Interrupt::Halt()
 //	"type" is the hardware device that generated the interrupt
 //----------------------------------------------------------------------
 void
-Interrupt::Schedule(VoidFunctionPtr handler, int arg, int fromNow, IntType type)
+Interrupt::Schedule(VoidFunctionPtr handler, IntPtr arg, int fromNow, IntType type)
 {
     int when = stats->totalTicks + fromNow;
     PendingInterrupt *toOccur = new PendingInterrupt(handler, arg, when, type);
@@ -271,7 +286,7 @@ Interrupt::Schedule(VoidFunctionPtr handler, int arg, int fromNow, IntType type)
 					intTypeNames[type], when);
     ASSERT(fromNow > 0);
 
-    pending->SortedInsert(toOccur, when);
+    pending->Insert(toOccur, when);
 }
 
 //----------------------------------------------------------------------
@@ -298,7 +313,7 @@ Interrupt::CheckIfDue(bool advanceClock)
     if (DebugIsEnabled('i'))
 	DumpState();
     PendingInterrupt *toOccur = 
-		(PendingInterrupt *)pending->SortedRemove(&when);
+		(PendingInterrupt *)pending->Min(&when);
 
     if (toOccur == NULL)		// no pending interrupts
 	return FALSE;			
@@ -306,20 +321,22 @@ Interrupt::CheckIfDue(bool advanceClock)
     if (advanceClock && when > stats->totalTicks) {	// advance the clock
 	stats->idleTicks += (when - stats->totalTicks);
 	stats->totalTicks = when;
-    } else if (when > stats->totalTicks) {	// not time yet, put it back
-	pending->SortedInsert(toOccur, when);
+    } else if (when > stats->totalTicks) {	// not time yet, leave it
 	return FALSE;
     }
 
 // Check if there is nothing more to do, and if so, quit
     if ((status == IdleMode) && (toOccur->type == TimerInt) 
-				&& pending->IsEmpty()) {
-	 pending->SortedInsert(toOccur, when);
+				&& pending->NumInHeap() == 1) {
 	 return FALSE;
     }
+    (void) pending->RemoveMin(NULL);
 
     DEBUG('i', "Invoking interrupt handler for the %s at time %d\n", 
 			intTypeNames[toOccur->type], toOccur->when);
+    if (eventLog != NULL)			// record it, or check it
+	eventLog->Deliver(toOccur->type, toOccur->when);	// is replayed
+						// in the right order
 #ifdef USER_PROGRAM
     if (machine != NULL)
     	machine->DelayedLoad(0, 0);
@@ -342,7 +359,7 @@ Interrupt::CheckIfDue(bool advanceClock)
 //----------------------------------------------------------------------
 
 static void
-PrintPending(int arg)
+PrintPending(IntPtr arg)
 {
     PendingInterrupt *pend = (PendingInterrupt *)arg;
 
@@ -15,9 +15,9 @@
 #endif
 
 // Dummy functions because C++ can't call member functions indirectly 
-static void NetworkReadPoll(int arg)
+static void NetworkReadPoll(IntPtr arg)
 { Network *net = (Network *)arg; net->CheckPktAvail(); }
-static void NetworkSendDone(int arg)
+static void NetworkSendDone(IntPtr arg)
 { Network *net = (Network *)arg; net->SendDone(); }
 
 // Initialize the network emulation
@@ -25,7 +25,7 @@ static void NetworkSendDone(int arg)
 //   reliability says whether we drop packets to emulate unreliable links
 //   readAvail, writeDone, callArg -- analogous to console
 Network::Network(NetworkAddress addr, double reliability,
-	VoidFunctionPtr readAvail, VoidFunctionPtr writeDone, int callArg)
+	VoidFunctionPtr readAvail, VoidFunctionPtr writeDone, IntPtr callArg)
 {
     ident = addr;
     if (reliability < 0) chanceToWork = 0;
@@ -45,7 +45,7 @@ Network::Network(NetworkAddress addr, double reliability,
 						 // in the current directory.
 
     // start polling for incoming packets
-    interrupt->Schedule(NetworkReadPoll, (int)this, NetworkTime, NetworkRecvInt);
+    interrupt->Schedule(NetworkReadPoll, (IntPtr) this, NetworkTime, NetworkRecvInt);
 }
 
 Network::~Network()
@@ -61,16 +61,28 @@ void
 Network::CheckPktAvail()
 {
     // schedule the next time to poll for a packet
-    interrupt->Schedule(NetworkReadPoll, (int)this, NetworkTime, NetworkRecvInt);
+    interrupt->Schedule(NetworkReadPoll, (IntPtr) this, NetworkTime, NetworkRecvInt);
 
     if (inHdr.length != 0) 	// do nothing if packet is already buffered
 	return;		
-    if (!PollSocket(sock)) 	// do nothing if no packet to be read
-	return;
-
-    // otherwise, read packet in
     char *buffer = new char[MaxWireSize];
-    ReadFromSocket(sock, buffer, MaxWireSize);
+    if (eventLog != NULL && eventLog->IsReplaying()) {
+	// take the packet, if one arrived at this point in the run
+	// being replayed, from the log
+	if (eventLog->ReplayInput(buffer, MaxWireSize) == 0) {
+	    delete []buffer;
+	    return;
+	}
+    } else {
+	if (!PollSocket(sock)) {	// do nothing if no packet to be read
+	    delete []buffer;
+	    return;
+	}
+	ReadFromSocket(sock, buffer, MaxWireSize);	// otherwise, read it in
+	if (eventLog != NULL)
+	    eventLog->RecordInput(buffer, sizeof(PacketHeader) +
+				((PacketHeader *) buffer)->length);
+    }
 
     // divide packet into header and data
     inHdr = *(PacketHeader *)buffer;
@@ -111,7 +123,7 @@ Network::Send(PacketHeader hdr, char* data)
 		&& (hdr.length <= MaxPacketSize) && (hdr.from == ident));
     DEBUG('n', "Sending to addr %d, %d bytes... ", hdr.to, hdr.length);
 
-    interrupt->Schedule(NetworkSendDone, (int)this, NetworkTime, NetworkSendInt);
+    interrupt->Schedule(NetworkSendDone, (IntPtr) this, NetworkTime, NetworkSendInt);
 
     if (Random() % 100 >= chanceToWork * 100) { // emulate a lost packet
 	DEBUG('n', "oops, lost it!\n");
@@ -122,7 +134,10 @@ Network::Send(PacketHeader hdr, char* data)
     char *buffer = new char[MaxWireSize];
     *(PacketHeader *)buffer = hdr;
     bcopy(data, buffer + sizeof(PacketHeader), hdr.length);
-    SendToSocket(sock, buffer, MaxWireSize, toName);
+    if (eventLog == NULL || !eventLog->IsReplaying())	// when replaying,
+	SendToSocket(sock, buffer, MaxWireSize, toName);	// the replies
+						// come from the log
+
     delete []buffer;
 }
 
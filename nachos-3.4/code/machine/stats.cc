@@ -9,6 +9,7 @@
 
 #include "copyright.h"
 #include "utility.h"
+#include "sysdep.h"
 #include "stats.h"
 
 //----------------------------------------------------------------------
@@ -21,6 +22,9 @@ Statistics::Statistics()
     numTLBmiss = 0;
     totalTicks = idleTicks = systemTicks = userTicks = 0;
     numDiskReads = numDiskWrites = 0;
+    numCacheHits = numCacheMisses = numCacheReadAheads = 0;
+    numDiskSeekTracks = diskQueueTicks = 0;
+    numFlashPrograms = numFlashMoves = numFlashErases = 0;
     numConsoleCharsRead = numConsoleCharsWritten = 0;
     numPageFaults = numPacketsSent = numPacketsRecvd = 0;
 }
@@ -37,6 +41,12 @@ Statistics::Print()
     printf("Ticks: total %d, idle %d, system %d, user %d\n", totalTicks, 
 	idleTicks, systemTicks, userTicks);
     printf("Disk I/O: reads %d, writes %d\n", numDiskReads, numDiskWrites);
+    printf("Disk queue: tracks seeked %d, ticks waiting %d\n",
+	numDiskSeekTracks, diskQueueTicks);
+    printf("Flash: pages programmed %d, moved %d, blocks erased %d\n",
+	numFlashPrograms, numFlashMoves, numFlashErases);
+    printf("Buffer cache: hits %d, misses %d, read ahead %d\n", numCacheHits,
+	numCacheMisses, numCacheReadAheads);
     printf("Console I/O: reads %d, writes %d\n", numConsoleCharsRead, 
 	numConsoleCharsWritten);
     printf("Paging: faults %d\n", numPageFaults);
@@ -44,3 +54,140 @@ Statistics::Print()
     printf("Network I/O: packets received %d, sent %d\n", numPacketsRecvd, 
 	numPacketsSent);
 }
+
+//----------------------------------------------------------------------
+// UsageStats::UsageStats
+// 	Initialize a thread's or address space's counters to zero.
+//----------------------------------------------------------------------
+
+UsageStats::UsageStats()
+{
+    userTicks = systemTicks = 0;
+    numPageFaults = numTLBmiss = 0;
+    numDiskReads = numDiskWrites = 0;
+}
+
+//----------------------------------------------------------------------
+// UsageStats::Print
+// 	Print the counters, on one line, labelled with "who".
+//----------------------------------------------------------------------
+
+void
+UsageStats::Print(char *who)
+{
+    printf("%s: ticks system %d, user %d; faults %d, TLB misses %d; "
+	"disk reads %d, writes %d\n", who, systemTicks, userTicks,
+	numPageFaults, numTLBmiss, numDiskReads, numDiskWrites);
+}
+
+//----------------------------------------------------------------------
+// Histogram::Histogram
+// 	Initialize an empty histogram.
+//----------------------------------------------------------------------
+
+Histogram::Histogram()
+{
+    for (int i = 0; i < HistogramBuckets; i++)
+	buckets[i] = 0;
+    count = total = max = 0;
+}
+
+//----------------------------------------------------------------------
+// Histogram::Add
+// 	Count one more "value".
+//----------------------------------------------------------------------
+
+void
+Histogram::Add(int value)
+{
+    int bucket;
+
+    for (bucket = 0; bucket < HistogramBuckets - 1 && (1 << bucket) <= value;
+								bucket++)
+	;
+    buckets[bucket]++;
+    count++;
+    total += value;
+    if (value > max)
+	max = value;
+}
+
+//----------------------------------------------------------------------
+// Histogram::Print
+// 	Print the buckets, one per line, leaving out the empty ones at
+//	either end.  The caller prints whatever goes above them.
+//----------------------------------------------------------------------
+
+void
+Histogram::Print()
+{
+    int first, last;
+
+    if (count == 0)
+	return;
+    for (first = 0; buckets[first] == 0; first++)
+	;
+    for (last = HistogramBuckets - 1; buckets[last] == 0; last--)
+	;
+    for (int i = first; i <= last; i++)
+	if (i == 0)
+	    printf("\t0:\t%d\n", buckets[i]);
+	else
+	    printf("\t< %d:\t%d\n", 1 << i, buckets[i]);
+}
+
+//----------------------------------------------------------------------
+// TraceWriter::TraceWriter
+// 	Start writing a trace to the UNIX file "fileName".
+//----------------------------------------------------------------------
+
+TraceWriter::TraceWriter(char *fileName)
+{
+    fd = OpenForWrite(fileName);
+    numBuffered = 0;
+}
+
+//----------------------------------------------------------------------
+// TraceWriter::~TraceWriter
+// 	Write out the rest of the trace, and close it.
+//----------------------------------------------------------------------
+
+TraceWriter::~TraceWriter()
+{
+    Flush();
+    Close(fd);
+}
+
+//----------------------------------------------------------------------
+// TraceWriter::Write
+// 	Add "text" to the trace, writing out the buffer first if there
+//	isn't room for it (or straight away, if it wouldn't fit at all).
+//----------------------------------------------------------------------
+
+void
+TraceWriter::Write(char *text)
+{
+    int len = strlen(text);
+
+    if (numBuffered + len > TraceBufferSize)
+	Flush();
+    if (len > TraceBufferSize) {
+	WriteFile(fd, text, len);
+	return;
+    }
+    bcopy(text, &buffer[numBuffered], len);
+    numBuffered += len;
+}
+
+//----------------------------------------------------------------------
+// TraceWriter::Flush
+// 	Write out the buffered trace.
+//----------------------------------------------------------------------
+
+void
+TraceWriter::Flush()
+{
+    if (numBuffered > 0)
+	WriteFile(fd, buffer, numBuffered);
+    numBuffered = 0;
+}
@@ -32,6 +32,14 @@ class Statistics {
 
     int numDiskReads;		// number of disk read requests
     int numDiskWrites;		// number of disk write requests
+    int numCacheHits;		// number of sectors found in the buffer cache
+    int numCacheMisses;		// number of sectors not found there
+    int numCacheReadAheads;	// number of sectors read ahead into it
+    int numDiskSeekTracks;	// number of tracks the disk head crossed
+    int diskQueueTicks;		// time disk requests spent queued
+    int numFlashPrograms;	// number of flash pages written,
+    int numFlashMoves;		// of those, moved by garbage collection
+    int numFlashErases;		// number of flash blocks erased
     int numConsoleCharsRead;	// number of characters read from the keyboard
     int numConsoleCharsWritten; // number of characters written to the display
     int numPageFaults;		// number of virtual memory page faults
@@ -43,6 +51,70 @@ class Statistics {
     void Print();		// print collected statistics
 };
 
+// The following class defines the statistics kept for a single thread,
+// or a single address space: the share of the global counters above
+// that it was responsible for.  They are charged as the events happen,
+// to whichever thread is running (and its address space, if any).
+
+class UsageStats {
+  public:
+    int userTicks;		// user instructions executed
+    int systemTicks;		// time spent in the kernel
+    int numPageFaults;		// virtual memory page faults
+    int numTLBmiss;		// TLB misses
+    int numDiskReads;		// disk sectors read
+    int numDiskWrites;		// disk sectors written
+
+    UsageStats();		// initialize everything to zero
+
+    void Print(char *who);	// print the counters, for "who"
+};
+
+// The following class defines a histogram of some quantity, such as
+// how long requests wait, by powers of two, along with the count,
+// total and maximum.  The fields are public, for the tracers that
+// write them out.
+
+#define HistogramBuckets 16	// bucket i holds values in [2^(i-1), 2^i);
+				// bucket 0 holds 0, the last one the rest
+
+class Histogram {
+  public:
+    int buckets[HistogramBuckets];
+    int count;			// # of values added
+    int total;			// their sum
+    int max;			// the biggest one
+
+    Histogram();		// an empty histogram
+
+    void Add(int value);	// count one more value
+    void Print();		// print the buckets, a line each
+};
+
+// The following class defines a trace file, written by the scheduler
+// and disk tracers.  Text is kept in a buffer, and written out when it
+// fills, so that tracing doesn't cost a UNIX write per event.
+
+#define TraceBufferSize	8192	// bytes of trace kept in memory before
+				// writing them out
+#define TraceNameLength	40	// most characters of a name put in a trace
+
+class TraceWriter {
+  public:
+    TraceWriter(char *fileName);	// start writing "fileName"
+				// (overwriting it if it exists)
+    ~TraceWriter();		// write out the rest, and close it
+
+    void Write(char *text);	// add "text" to the trace
+
+  private:
+    int fd;			// the trace file
+    char buffer[TraceBufferSize];	// trace not yet written out
+    int numBuffered;		// # of bytes in buffer
+
+    void Flush();		// write out the buffer
+};
+
 // Constants used to reflect the relative time an operation would
 // take in a real system.  A "tick" is a just a unit of time -- if you 
 // like, a microsecond.
@@ -55,6 +127,9 @@ class Statistics {
 #define SystemTick 	10 	// advance each time interrupts are enabled
 #define RotationTime 	500 	// time disk takes to rotate one sector
 #define SeekTime 	500    	// time disk takes to seek past one track
+#define FlashReadTime	25	// time flash takes to read one page,
+#define FlashProgramTime 200	// to program (write) one,
+#define FlashEraseTime	1500	// and to erase a block of them
 #define ConsoleTime 	100	// time to read or write one character
 #define NetworkTime 	100   	// time to send or receive one packet
 #define TimerTicks 	100    	// (average) time between timer interrupts
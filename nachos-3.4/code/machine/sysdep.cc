@@ -35,11 +35,15 @@ extern "C" {
 #include <sys/file.h>
 #include <sys/un.h>
 #include <sys/mman.h>
-#ifdef HOST_i386
+#include <sys/uio.h>
+#if defined(HOST_i386) || defined(HOST_x86_64)
 #include <unistd.h>
 #include <sys/time.h>
 #include <errno.h>
 #endif
+#ifdef HOST_x86_64
+#include <sys/select.h>
+#endif
 #ifdef HOST_SPARC
 #include <unistd.h>
 #include <fcntl.h>
@@ -56,6 +60,9 @@ extern "C" {
   //int creat(const char *name, unsigned short mode);
   //int open(const char *name, int flags, ...);
 // void signal(int sig, VoidFunctionPtr func); -- this may work now!
+#ifdef HOST_x86_64
+// select is declared in <sys/select.h>
+#else
 #ifdef HOST_i386
 int select(int nfds, fd_set *readfds, fd_set *writefds, fd_set *exceptfds,
              struct timeval *timeout);
@@ -68,6 +75,7 @@ int select(int numBits, void *readFds, void *writeFds, void *exceptFds,
 	struct timeval *timeout);
 #endif
 #endif
+#endif
 #endif
 
   //int unlink(char *name);
@@ -120,7 +128,12 @@ void exit(int);
 bool
 PollFile(int fd)
 {
-    int rfd = (1 << fd), wfd = 0, xfd = 0, retVal;
+#ifdef HOST_x86_64
+    fd_set rfd;			// a 32-bit int is too small for an fd_set here
+#else
+    int rfd = (1 << fd), wfd = 0, xfd = 0;
+#endif
+    int retVal;
     struct timeval pollTime;
 
 // decide how long to wait if there are no characters on the file
@@ -131,7 +144,11 @@ PollFile(int fd)
         pollTime.tv_usec = 0;                 	// no delay
 
 // poll file or socket
-#if (defined(HOST_i386) || defined(HOST_SPARC)) 
+#ifdef HOST_x86_64
+    FD_ZERO(&rfd);
+    FD_SET(fd, &rfd);
+    retVal = select(fd + 1, &rfd, NULL, NULL, &pollTime);
+#elif (defined(HOST_i386) || defined(HOST_SPARC)) 
     retVal = select(32, (fd_set*)&rfd, (fd_set*)&wfd, (fd_set*)&xfd, &pollTime);
 #else
     retVal = select(32, &rfd, &wfd, &xfd, &pollTime);
@@ -214,6 +231,85 @@ WriteFile(int fd, char *buffer, int nBytes)
     ASSERT(retVal == nBytes);
 }
 
+//----------------------------------------------------------------------
+// ReadVector, WriteVector
+// 	Read/write "numBuffers" buffers, each "size" bytes long, from/to
+//	consecutive places in an open file, starting at "offset", all in
+//	one system call.  Abort if any of it fails.
+//----------------------------------------------------------------------
+
+#define MaxVector	64		// most buffers in one call
+
+void
+ReadVector(int fd, char **buffers, int numBuffers, int size, int offset)
+{
+    struct iovec iov[MaxVector];
+    int retVal;
+
+    ASSERT(numBuffers <= MaxVector);
+    for (int i = 0; i < numBuffers; i++) {
+	iov[i].iov_base = buffers[i];
+	iov[i].iov_len = size;
+    }
+    retVal = preadv(fd, iov, numBuffers, offset);
+    ASSERT(retVal == numBuffers * size);
+}
+
+void
+WriteVector(int fd, char **buffers, int numBuffers, int size, int offset)
+{
+    struct iovec iov[MaxVector];
+    int retVal;
+
+    ASSERT(numBuffers <= MaxVector);
+    for (int i = 0; i < numBuffers; i++) {
+	iov[i].iov_base = buffers[i];
+	iov[i].iov_len = size;
+    }
+    retVal = pwritev(fd, iov, numBuffers, offset);
+    ASSERT(retVal == numBuffers * size);
+}
+
+//----------------------------------------------------------------------
+// MapFile
+// 	Map the first "size" bytes of an open file into memory, shared,
+//	so that changes to the memory are changes to the file.  Abort on
+//	error.
+//----------------------------------------------------------------------
+
+char *
+MapFile(int fd, int size)
+{
+    void *addr = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+
+    ASSERT(addr != MAP_FAILED);
+    return (char *) addr;
+}
+
+//----------------------------------------------------------------------
+// SyncMappedFile
+// 	Write the changes made to a mapped file out to the file itself.
+//----------------------------------------------------------------------
+
+void
+SyncMappedFile(char *addr, int size)
+{
+    int retVal = msync(addr, size, MS_SYNC);
+    ASSERT(retVal == 0);
+}
+
+//----------------------------------------------------------------------
+// UnmapFile
+// 	Undo MapFile.
+//----------------------------------------------------------------------
+
+void
+UnmapFile(char *addr, int size)
+{
+    int retVal = munmap(addr, size);
+    ASSERT(retVal == 0);
+}
+
 //----------------------------------------------------------------------
 // Lseek
 // 	Change the location within an open file.  Abort on error.
@@ -234,7 +330,7 @@ Lseek(int fd, int offset, int whence)
 int 
 Tell(int fd)
 {
-#ifdef HOST_i386
+#if defined(HOST_i386) || defined(HOST_x86_64)
     return lseek(fd,0,SEEK_CUR); // 386BSD doesn't have the tell() system call
 #else
     return tell(fd);
@@ -357,8 +453,8 @@ ReadFromSocket(int sockID, char *buffer, int packetSize)
     int retVal;
     //    extern int errno;	errno sometimes defined as a macro
     struct sockaddr_un uName;
-#ifdef HOST_i386
-    unsigned int size = sizeof(uName);
+#if defined(HOST_i386) || defined(HOST_x86_64)
+    socklen_t size = sizeof(uName);
 #else
     int size = sizeof(uName);
 #endif
@@ -368,7 +464,7 @@ ReadFromSocket(int sockID, char *buffer, int packetSize)
 
     if (retVal != packetSize) {
         perror("in recvfrom");
-        printf("called: %x, got back %d, %d\n", (unsigned int) buffer, retVal, errno);
+        printf("called: %p, got back %d, %d\n", (void *) buffer, retVal, errno);
     }
     ASSERT(retVal == packetSize);
 }
@@ -400,7 +496,7 @@ SendToSocket(int sockID, char *buffer, int packetSize, char *toName)
 void 
 CallOnUserAbort(VoidNoArgFunctionPtr func)
 {
-    (void)signal(SIGINT, (VoidFunctionPtr) func);
+    (void)signal(SIGINT, (void (*)(int)) func);
 }
 
 //----------------------------------------------------------------------
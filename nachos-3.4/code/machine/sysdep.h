@@ -25,7 +25,14 @@ extern void Read(int fd, char *buffer, int nBytes);
 extern int ReadPartial(int fd, char *buffer, int nBytes);
 extern void WriteFile(int fd, char *buffer, int nBytes);
 extern void Lseek(int fd, int offset, int whence);
+extern void ReadVector(int fd, char **buffers, int numBuffers, int size,
+							int offset);
+extern void WriteVector(int fd, char **buffers, int numBuffers, int size,
+							int offset);
 extern int Tell(int fd);
+extern char *MapFile(int fd, int size);
+extern void SyncMappedFile(char *addr, int size);
+extern void UnmapFile(char *addr, int size);
 extern void Close(int fd);
 extern bool Unlink(char *name);
 
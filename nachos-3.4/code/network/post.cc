@@ -45,13 +45,13 @@ Mail::Mail(PacketHeader pktH, MailHeader mailH, char *msgData)
 //      Initialize a single mail box within the post office, so that it
 //	can receive incoming messages.
 //
-//	Just initialize a list of messages, representing the mailbox.
+//	Just initialize a queue of messages, representing the mailbox.
 //----------------------------------------------------------------------
 
 
 MailBox::MailBox()
 { 
-    messages = new SynchList(); 
+    messages = new SynchQueue("mailbox", MailBoxSize); 
 }
 
 //----------------------------------------------------------------------
@@ -89,7 +89,11 @@ PrintHeader(PacketHeader pktHdr, MailHeader mailHdr)
 //	arrival, wake them up!
 //
 //	We need to reconstruct the Mail message (by concatenating the headers
-//	to the data), to simplify queueing the message on the SynchList.
+//	to the data), to simplify queueing the message on the SynchQueue.
+//
+//	If the mailbox is full, the message is dropped rather than making
+//	the PostOffice wait -- that would hold up mail for every other
+//	mailbox too.  The network is unreliable anyway.
 //
 //	"pktHdr" -- source, destination machine ID's
 //	"mailHdr" -- source, destination mailbox ID's
@@ -101,9 +105,12 @@ MailBox::Put(PacketHeader pktHdr, MailHeader mailHdr, char *data)
 { 
     Mail *mail = new Mail(pktHdr, mailHdr, data); 
 
-    messages->Append((void *)mail);	// put on the end of the list of 
-					// arrived messages, and wake up 
+    if (!messages->TryPut((void *)mail)) {	// put on the end of the queue
+					// of arrived messages, and wake up
 					// any waiters
+	DEBUG('n', "Mailbox %d full, dropping message\n", mailHdr.to);
+	delete mail;
+    }
 }
 
 //----------------------------------------------------------------------
@@ -122,8 +129,8 @@ void
 MailBox::Get(PacketHeader *pktHdr, MailHeader *mailHdr, char *data) 
 { 
     DEBUG('n', "Waiting for mail in mailbox\n");
-    Mail *mail = (Mail *) messages->Remove();	// remove message from list;
-						// will wait if list is empty
+    Mail *mail = (Mail *) messages->Get();	// remove message from queue;
+						// will wait if queue is empty
 
     *pktHdr = mail->pktHdr;
     *mailHdr = mail->mailHdr;
@@ -147,11 +154,11 @@ MailBox::Get(PacketHeader *pktHdr, MailHeader *mailHdr, char *data)
 //	"arg" -- pointer to the Post Office managing the Network
 //----------------------------------------------------------------------
 
-static void PostalHelper(int arg)
+static void PostalHelper(IntPtr arg)
 { PostOffice* po = (PostOffice *) arg; po->PostalDelivery(); }
-static void ReadAvail(int arg)
+static void ReadAvail(IntPtr arg)
 { PostOffice* po = (PostOffice *) arg; po->IncomingPacket(); }
-static void WriteDone(int arg)
+static void WriteDone(IntPtr arg)
 { PostOffice* po = (PostOffice *) arg; po->PacketSent(); }
 
 //----------------------------------------------------------------------
@@ -186,14 +193,14 @@ PostOffice::PostOffice(NetworkAddress addr, double reliability, int nBoxes)
     boxes = new MailBox[nBoxes];
 
 // Third, initialize the network; tell it which interrupt handlers to call
-    network = new Network(addr, reliability, ReadAvail, WriteDone, (int) this);
+    network = new Network(addr, reliability, ReadAvail, WriteDone, (IntPtr) this);
 
 
 // Finally, create a thread whose sole job is to wait for incoming messages,
 //   and put them in the right mailbox. 
     Thread *t = new Thread("postal worker");
 
-    t->Fork(PostalHelper, (int) this);
+    t->Fork(PostalHelper, (IntPtr) this);
 }
 
 //----------------------------------------------------------------------
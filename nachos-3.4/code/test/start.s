@@ -162,6 +162,22 @@ Seek:
 	j	$31
 	.end Exit
 
+	.globl Sleep
+	.ent	Sleep
+Sleep:
+	addiu $2,$0,SC_Sleep
+	syscall
+	j	$31
+	.end Sleep
+
+	.globl GetStats
+	.ent	GetStats
+GetStats:
+	addiu $2,$0,SC_GetStats
+	syscall
+	j	$31
+	.end GetStats
+
 
 /* dummy function to keep gcc happy */
         .globl  __main
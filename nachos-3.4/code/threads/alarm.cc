@@ -0,0 +1,150 @@
+// alarm.cc 
+//	Routines to put threads to sleep until a given simulated time,
+//	and to wake them up again.
+//
+//	Interrupt::Schedule has no way to take back an interrupt once
+//	it has been scheduled.  So if a thread wants to be woken up
+//	earlier than the alarm is set for, we schedule a second alarm
+//	interrupt; when the later one goes off, it simply finds nothing
+//	(or less) to do.
+//
+// Copyright (c) 1992-1993 The Regents of the University of California.
+// All rights reserved.  See copyright.h for copyright notice and limitation 
+// of liability and disclaimer of warranty provisions.
+
+#include "copyright.h"
+#include "alarm.h"
+#include "system.h"
+
+//----------------------------------------------------------------------
+// AlarmHandler
+// 	Interrupt handler for the alarm.  Since a C++ member function
+//	can't be used as an interrupt handler, we pass the Alarm
+//	object as the argument, as the Timer and Disk do.
+//
+//	"arg" is a pointer to the Alarm object
+//----------------------------------------------------------------------
+
+static void
+AlarmHandler(IntPtr arg)
+{
+    Alarm *alarm = (Alarm *)arg;
+
+    alarm->CallBack();
+}
+
+//----------------------------------------------------------------------
+// Alarm::Alarm
+// 	Initialize the alarm clock, with no one sleeping.
+//
+//	"slackTicks" is how many ticks late a thread may be woken up,
+//		so that its wakeup can share an interrupt with another's
+//----------------------------------------------------------------------
+
+Alarm::Alarm(int slackTicks)
+{
+    ASSERT(slackTicks >= 0);
+    sleepers = new Heap();
+    slack = slackTicks;
+    nextAlarm = -1;
+}
+
+//----------------------------------------------------------------------
+// Alarm::~Alarm
+// 	De-allocate the alarm clock.  Assume no one is still asleep!
+//----------------------------------------------------------------------
+
+Alarm::~Alarm()
+{
+    ASSERT(sleepers->IsEmpty());
+    delete sleepers;
+}
+
+//----------------------------------------------------------------------
+// Alarm::ScheduleAlarm
+// 	Make sure an alarm interrupt will go off at "when", or up to
+//	"slack" ticks after it.  If the pending alarm already will,
+//	there's nothing to do; otherwise schedule another for "when".
+//	(Never rely on one that goes off earlier: the thread would be
+//	woken too soon.)
+//
+//	"when" is the time the soonest sleeper wants to be woken up
+//----------------------------------------------------------------------
+
+void
+Alarm::ScheduleAlarm(int when)
+{
+    if (nextAlarm >= when && nextAlarm <= when + slack)
+	return;				// coalesce with the pending alarm
+
+    nextAlarm = when;
+    DEBUG('t', "Scheduling alarm for time %d\n", when);
+    interrupt->Schedule(AlarmHandler, (IntPtr) this,
+				when - stats->totalTicks, AlarmInt);
+}
+
+//----------------------------------------------------------------------
+// Alarm::WaitUntil
+// 	Put the current thread to sleep until the simulated time is
+//	at least "when" (or up to "slack" ticks after that).  Returns
+//	immediately if "when" isn't in the future.
+//
+//	"when" is the time at which to wake up
+//----------------------------------------------------------------------
+
+void
+Alarm::WaitUntil(int when)
+{
+    IntStatus oldLevel = interrupt->SetLevel(IntOff);
+
+    if (when > stats->totalTicks) {
+	DEBUG('t', "Thread \"%s\" sleeping until time %d\n",
+					currentThread->getName(), when);
+	sleepers->Insert((void *)currentThread, when);
+	ScheduleAlarm(when);
+	currentThread->Sleep();
+    }
+    (void) interrupt->SetLevel(oldLevel);
+}
+
+//----------------------------------------------------------------------
+// Alarm::SleepFor
+// 	Put the current thread to sleep for "ticks" of simulated time.
+//----------------------------------------------------------------------
+
+void
+Alarm::SleepFor(int ticks)
+{
+    WaitUntil(stats->totalTicks + ticks);
+}
+
+//----------------------------------------------------------------------
+// Alarm::CallBack
+// 	The alarm interrupt has gone off.  Wake up every thread that is
+//	due, then schedule the alarm for the next sleeper, if any.
+//	A thread is never woken before its time; the slack only
+//	decides when the alarm goes off.
+//
+//	Called from the interrupt handler, with interrupts disabled.
+//----------------------------------------------------------------------
+
+void
+Alarm::CallBack()
+{
+    int now = stats->totalTicks;
+    int when;
+    Thread *thread;
+
+    if (nextAlarm != -1 && nextAlarm <= now)
+	nextAlarm = -1;			// this is the alarm we scheduled
+
+    while ((thread = (Thread *)sleepers->Min(&when)) != NULL
+					&& when <= now) {
+	(void) sleepers->RemoveMin(NULL);
+	DEBUG('t', "Waking up thread \"%s\" at time %d (wanted %d)\n",
+					thread->getName(), now, when);
+	scheduler->ReadyToRun(thread);
+    }
+    if (thread != NULL)
+	ScheduleAlarm(when);
+}
@@ -0,0 +1,55 @@
+// alarm.h 
+//	Data structures for putting threads to sleep until a given
+//	simulated time.
+//
+//	Sleeping threads are kept in a heap, soonest wakeup first.  Only
+//	one alarm interrupt is scheduled at a time, for the soonest
+//	wakeup; when it goes off, every thread that is due is put back
+//	on the ready list, and the next alarm interrupt is scheduled.
+//
+//	To cut down on the number of interrupts, wakeups are coalesced:
+//	a thread may be woken up to "slack" ticks late, if that lets it
+//	share an interrupt with another thread.  With a slack of 0,
+//	every thread is woken up exactly on time.
+//
+//	While threads are asleep, they are not on the ready list, so if
+//	nothing else is runnable, Interrupt::Idle can fast-forward the
+//	clock straight to the next wakeup.
+//
+// Copyright (c) 1992-1993 The Regents of the University of California.
+// All rights reserved.  See copyright.h for copyright notice and limitation 
+// of liability and disclaimer of warranty provisions.
+
+#ifndef ALARM_H
+#define ALARM_H
+
+#include "copyright.h"
+#include "heap.h"
+
+// The following class defines the alarm clock.
+
+class Alarm {
+  public:
+    Alarm(int slackTicks);		// Initialize the alarm clock, with
+					// no one sleeping
+    ~Alarm();				// De-allocate the alarm clock
+
+    void WaitUntil(int when);		// Put the current thread to sleep
+					// until time "when"
+    void SleepFor(int ticks);		// ... or for "ticks" from now
+
+    void CallBack();			// Called when the alarm interrupt
+					// goes off; wakes up threads
+
+  private:
+    Heap *sleepers;			// sleeping threads, keyed by when
+					// they should be woken up
+    int slack;				// how late a thread may be woken
+    int nextAlarm;			// when the alarm interrupt will next
+					// go off, -1 if none is scheduled
+
+    void ScheduleAlarm(int when);	// make sure the alarm goes off
+					// between "when" and "when" + "slack"
+};
+
+#endif // ALARM_H
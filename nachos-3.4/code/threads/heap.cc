@@ -0,0 +1,197 @@
+// heap.cc 
+//
+//     	Routines to manage a binary heap of "things".
+//
+//	The heap is kept in an array: the children of elements[i] are
+//	elements[2i+1] and elements[2i+2].  The array is doubled in size
+//	whenever it fills up.
+//
+//	Ties between equal keys are broken by a sequence number, handed
+//	out in Insert order, so equal keys come out first-in, first-out.
+//	The comparison on sequence numbers is done with wrap-around
+//	arithmetic, so it stays correct as long as no two items in the
+//	heap at the same time were inserted more than 2^31 Inserts apart.
+// 
+//     	NOTE: Mutual exclusion must be provided by the caller.
+//
+// Copyright (c) 1992-1993 The Regents of the University of California.
+// All rights reserved.  See copyright.h for copyright notice and limitation 
+// of liability and disclaimer of warranty provisions.
+
+#include "copyright.h"
+#include "heap.h"
+
+#define InitialHeapSize	16
+
+//----------------------------------------------------------------------
+// Heap::Heap
+//	Initialize a heap, empty to start with.
+//----------------------------------------------------------------------
+
+Heap::Heap()
+{
+    maxInHeap = InitialHeapSize;
+    elements = new HeapElement[maxInHeap];
+    numInHeap = 0;
+    nextSeq = 0;
+}
+
+//----------------------------------------------------------------------
+// Heap::~Heap
+//	De-allocate a heap.  As with List, this does not de-allocate
+//	the items themselves.
+//----------------------------------------------------------------------
+
+Heap::~Heap()
+{
+    delete [] elements;
+}
+
+//----------------------------------------------------------------------
+// Heap::Less, Heap::Swap
+//	Compare two elements (by key, then by insertion order), and
+//	exchange two elements.
+//----------------------------------------------------------------------
+
+bool
+Heap::Less(int i, int j)
+{
+    if (elements[i].key != elements[j].key)
+	return (elements[i].key < elements[j].key);
+    return ((int) (elements[i].seq - elements[j].seq) < 0);
+}
+
+void
+Heap::Swap(int i, int j)
+{
+    HeapElement tmp = elements[i];
+
+    elements[i] = elements[j];
+    elements[j] = tmp;
+}
+
+//----------------------------------------------------------------------
+// Heap::SiftUp
+//	Move elements[i] up towards the root, until its parent is
+//	no bigger than it is.
+//----------------------------------------------------------------------
+
+void
+Heap::SiftUp(int i)
+{
+    while (i > 0 && Less(i, (i - 1) / 2)) {
+	Swap(i, (i - 1) / 2);
+	i = (i - 1) / 2;
+    }
+}
+
+//----------------------------------------------------------------------
+// Heap::SiftDown
+//	Move elements[i] down towards the leaves, until neither of its
+//	children is smaller than it is.
+//----------------------------------------------------------------------
+
+void
+Heap::SiftDown(int i)
+{
+    for (;;) {
+	int smallest = i;
+	int left = 2 * i + 1;
+	int right = 2 * i + 2;
+
+	if (left < numInHeap && Less(left, smallest))
+	    smallest = left;
+	if (right < numInHeap && Less(right, smallest))
+	    smallest = right;
+	if (smallest == i)
+	    return;
+	Swap(i, smallest);
+	i = smallest;
+    }
+}
+
+//----------------------------------------------------------------------
+// Heap::Insert
+//      Put an "item" into the heap, growing the array if it is full.
+//
+//	"item" is the thing to put in the heap, it can be a pointer to 
+//		anything.
+//	"sortKey" is the priority of the item.
+//----------------------------------------------------------------------
+
+void
+Heap::Insert(void *item, int sortKey)
+{
+    if (numInHeap == maxInHeap) {
+	HeapElement *bigger = new HeapElement[maxInHeap * 2];
+
+	for (int i = 0; i < numInHeap; i++)
+	    bigger[i] = elements[i];
+	delete [] elements;
+	elements = bigger;
+	maxInHeap *= 2;
+    }
+    elements[numInHeap].item = item;
+    elements[numInHeap].key = sortKey;
+    elements[numInHeap].seq = nextSeq++;
+    numInHeap++;
+    SiftUp(numInHeap - 1);
+}
+
+//----------------------------------------------------------------------
+// Heap::Min
+//      Return the smallest item in the heap, without removing it.
+//
+// Returns:
+//	Pointer to the item, NULL if the heap is empty.
+//	Sets *keyPtr to the priority value of the item, if keyPtr
+//	isn't NULL.
+//----------------------------------------------------------------------
+
+void *
+Heap::Min(int *keyPtr)
+{
+    if (IsEmpty())
+	return NULL;
+    if (keyPtr != NULL)
+	*keyPtr = elements[0].key;
+    return elements[0].item;
+}
+
+//----------------------------------------------------------------------
+// Heap::RemoveMin
+//      Remove the smallest item from the heap.
+//
+// Returns:
+//	Pointer to removed item, NULL if the heap is empty.
+//	Sets *keyPtr to the priority value of the removed item, if
+//	keyPtr isn't NULL.
+//----------------------------------------------------------------------
+
+void *
+Heap::RemoveMin(int *keyPtr)
+{
+    void *thing = Min(keyPtr);
+
+    if (thing == NULL)
+	return NULL;
+    numInHeap--;
+    elements[0] = elements[numInHeap];
+    SiftDown(0);
+    return thing;
+}
+
+//----------------------------------------------------------------------
+// Heap::Mapcar
+//	Apply a function to each item in the heap, in array order
+//	(which is *not* sorted order).
+//
+//	"func" is the procedure to apply to each item.
+//----------------------------------------------------------------------
+
+void
+Heap::Mapcar(VoidFunctionPtr func)
+{
+    for (int i = 0; i < numInHeap; i++)
+	(*func)((IntPtr)elements[i].item);
+}
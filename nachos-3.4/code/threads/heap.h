@@ -0,0 +1,68 @@
+// heap.h 
+//	Data structures to manage a priority queue of "things", kept as
+//	a binary heap.
+//
+//	Like a sorted List, a Heap holds pointers to anything, each with
+//	an integer key, and hands them back smallest key first.  Unlike
+//	a sorted List, putting an item in takes O(log n) time rather
+//	than O(n), and looking at the smallest item takes O(1).
+//
+//	Items with equal keys come out in the order they were put in,
+//	just as with List::SortedInsert.
+//
+// Copyright (c) 1992-1993 The Regents of the University of California.
+// All rights reserved.  See copyright.h for copyright notice and limitation 
+// of liability and disclaimer of warranty provisions.
+
+#ifndef HEAP_H
+#define HEAP_H
+
+#include "copyright.h"
+#include "utility.h"
+
+// The following class defines one slot in a heap -- an item, its key,
+// and a sequence number, used to break ties between equal keys.
+//
+// Internal data structures kept public so that Heap operations can
+// access them directly.
+
+class HeapElement {
+  public:
+    void *item;			// pointer to item in the heap
+    int key;			// priority, smallest comes out first
+    unsigned int seq;		// when the item was put in, for FIFO order
+				// among equal keys
+};
+
+// The following class defines a "heap" -- an array of heap elements,
+// arranged so that each element is no bigger than its children.
+// The array grows as needed.
+
+class Heap {
+  public:
+    Heap();			// initialize the heap
+    ~Heap();			// de-allocate the heap
+
+    void Insert(void *item, int sortKey);	// Put item into heap
+    void *RemoveMin(int *keyPtr);	// Remove smallest item from heap
+    void *Min(int *keyPtr);		// Return smallest item, without
+					// removing it
+
+    void Mapcar(VoidFunctionPtr func);	// Apply "func" to every item in
+					// the heap (in no particular order)
+    bool IsEmpty() { return (numInHeap == 0); }	// is the heap empty? 
+    int NumInHeap() { return numInHeap; }	// how many items?
+
+  private:
+    HeapElement *elements;	// the heap; elements[0] is the smallest
+    int numInHeap;		// # of elements in use
+    int maxInHeap;		// # of elements allocated
+    unsigned int nextSeq;	// sequence number for the next Insert
+
+    bool Less(int i, int j);	// should elements[i] come out first?
+    void Swap(int i, int j);
+    void SiftUp(int i);		// restore heap order, after elements[i]
+    void SiftDown(int i);	// got smaller or bigger, respectively
+};
+
+#endif // HEAP_H
@@ -141,8 +141,9 @@ void
 List::Mapcar(VoidFunctionPtr func)
 {
     for (ListElement *ptr = first; ptr != NULL; ptr = ptr->next) {
-       DEBUG('l', "In mapcar, about to invoke %x(%x)\n", func, ptr->item);
-       (*func)((int)ptr->item);
+       DEBUG('l', "In mapcar, about to invoke %p(%p)\n", (void *) func,
+								ptr->item);
+       (*func)((IntPtr)ptr->item);
     }
 }
 
@@ -188,6 +189,11 @@ List::SortedInsert(void *item, int sortKey)
 		// item goes on front of list
 	element->next = first;
 	first = element;
+    } else if (sortKey >= last->key) {
+		// item goes on end of list -- the common case, when most
+		// items have the same key, so don't walk the list
+	last->next = element;
+	last = element;
     } else {		// look for first elt in list bigger than item
         for (ptr = first; ptr->next != NULL; ptr = ptr->next) {
             if (sortKey < ptr->next->key) {
@@ -236,3 +242,92 @@ List::SortedRemove(int *keyPtr)
     return thing;
 }
 
+//----------------------------------------------------------------------
+// List::SortedMerge
+//      Move every item from the sorted list "other" into this sorted
+//	list, in a single pass over the two lists.  The result is the
+//	same as taking each item off the front of "other" and calling
+//	SortedInsert with it -- items on this list stay ahead of items
+//	from "other" with the same key -- but much faster when there
+//	are a lot of items.  "other" is left empty.
+//
+//	"other" is the list of items to move; it must be sorted by key.
+//----------------------------------------------------------------------
+
+void
+List::SortedMerge(List *other)
+{
+    ListElement *prev = NULL;	// last element placed so far
+    ListElement *ptr = first;	// first element not yet passed over
+    ListElement *element;
+
+    while (other->first != NULL) {
+	element = other->first;
+	other->first = element->next;
+	while (ptr != NULL && ptr->key <= element->key) {
+	    prev = ptr;
+	    ptr = ptr->next;
+	}
+	element->next = ptr;
+	if (prev == NULL)
+	    first = element;
+	else
+	    prev->next = element;
+	if (ptr == NULL)
+	    last = element;
+	prev = element;
+    }
+    other->last = NULL;
+}
+
+//----------------------------------------------------------------------
+// List::Front
+//      Return the first "item" on the list, without removing it.
+//
+// Returns:
+//	Pointer to the first item, NULL if nothing on the list.
+//	Sets *keyPtr to the priority value of the item, as in SortedRemove.
+//----------------------------------------------------------------------
+
+void *
+List::Front(int *keyPtr)
+{
+    if (IsEmpty())
+	return NULL;
+    if (keyPtr != NULL)
+	*keyPtr = first->key;
+    return first->item;
+}
+
+//----------------------------------------------------------------------
+// List::RemoveItem
+//      Remove "item" from the list, wherever it is.  Used when an item
+//	needs to move to a new place in a sorted list, for instance
+//	when a waiting thread's priority changes.
+//
+// Returns:
+//	TRUE if "item" was found (and removed), FALSE otherwise.
+//
+//	"item" is the thing to take off the list.
+//----------------------------------------------------------------------
+
+bool
+List::RemoveItem(void *item)
+{
+    ListElement *prev = NULL;
+    ListElement *ptr;
+
+    for (ptr = first; ptr != NULL; prev = ptr, ptr = ptr->next) {
+	if (ptr->item == item) {
+	    if (prev == NULL)
+		first = ptr->next;
+	    else
+		prev->next = ptr->next;
+	    if (last == ptr)
+		last = prev;
+	    delete ptr;
+	    return TRUE;
+	}
+    }
+    return FALSE;
+}
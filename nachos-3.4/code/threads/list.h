@@ -57,6 +57,12 @@ class List {
     // Routines to put/get items on/off list in order (sorted by key)
     void SortedInsert(void *item, int sortKey);	// Put item into list
     void *SortedRemove(int *keyPtr); 	  	// Remove first item from list
+    void SortedMerge(List *other);	// Move every item on sorted list
+					// "other" into this list, in order
+
+    void *Front(int *keyPtr);	// Return first item, without removing it
+    bool RemoveItem(void *item);	// Take "item" off the list, wherever
+					// it is; FALSE if it wasn't there
 
   private:
     ListElement *first;  	// Head of the list, NULL if list is empty
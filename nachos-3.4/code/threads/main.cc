@@ -8,16 +8,25 @@
 //
 // 	Most of this file is not needed until later assignments.
 //
-// Usage: nachos -d <debugflags> -rs <random seed #>
+// Usage: nachos -d <debugflags> -rs <random seed #> -tr <trace file>
+//		-rec <event log> -rep <event log> -as <alarm slack>
 //		-s -x <nachos file> -c <consoleIn> <consoleOut>
 //		-f -cp <unix file> <nachos file>
 //		-p <nachos file> -r <nachos file> -l -D -t
+//		-ds <fcfs|sstf|scan|clook> -dt -dm [<sync interval>]
+//		-dg <sectors per track> <tracks> -dv <stripe|mirror> <disks>
+//		-dtrace <trace file> -dstat -dk <disk|flash>
 //              -n <network reliability> -m <machine id>
 //              -o <other machine id>
 //              -z
 //
 //    -d causes certain debugging messages to be printed (cf. utility.h)
 //    -rs causes Yield to occur at random (but repeatable) spots
+//    -tr writes a trace of the scheduler to a file, in Chrome's format
+//    -rec records every interrupt, and any console or network input,
+//	to a file; -rep replays them (give the same -rs seed both times)
+//    -as lets sleeping threads be woken up to so many ticks late, so
+//	that their wakeups can share an alarm interrupt
 //    -z prints the copyright message
 //
 //  USER_PROGRAM
@@ -27,12 +36,24 @@
 //
 //  FILESYS
 //    -f causes the physical disk to be formatted
+//    -dg sets the shape of the disk, when it is formatted
+//    -dv puts the file system on several disks (DISK, DISK1, ...),
+//	striped or mirrored; give it the same way every time
 //    -cp copies a file from UNIX to Nachos
 //    -p prints a Nachos file to stdout
 //    -r removes a Nachos file from the file system
 //    -l lists the contents of the Nachos directory
 //    -D prints the contents of the entire file system 
 //    -t tests the performance of the Nachos file system
+//    -ds sets the order disk requests are served in (default clook)
+//    -dt tests the disk scheduler, with several threads reading at once
+//    -dm maps the DISK file into memory, syncing it every so many
+//	disk writes if given (and at the end)
+//    -dk simulates flash memory instead of a rotating disk (the
+//	device's contents are the same either way; only timing differs)
+//    -dtrace writes a line for every disk request to a CSV file;
+//	with it, or with -dstat, histograms of disk request times are
+//	printed when Nachos halts
 //
 //  NETWORK
 //    -n sets the network reliability
@@ -61,31 +82,17 @@ extern int testnum;
 extern int xianchengnum;
 
 #endif
-typedef struct 
-{
-	Thread *p;
-	bool b = false;
-}aa;
-
-extern aa *a;
 // External functions used by this file
 
 extern void ThreadTest(void), Copy(char *unixFile, char *nachosFile);
-extern void Print(char *file), PerformanceTest(void);
+extern void Print(char *file), PerformanceTest(void), DiskSchedTest(void);
 extern void StartProcess(char *file), ConsoleTest(char *in, char *out), SynchConsoleTest(char *in, char *out);
 extern void MailTest(int networkID);
 
 void havefun()
 {
 	printf("------------------\nthe left threads' names are:\n");
-	for(int i = 0; i < 128; i ++)
-	{
-		if(a[i].b == true)
-		{
-			//printf("%drrrrrrrrrrrrrrrrr\n", i);
-			printf("%s\n", (a[i].p)->getName());
-		}
-	}
+	threadTable->Print();
 	printf("------------------\n");
 }
 
@@ -185,6 +192,8 @@ main(int argc, char **argv)
             fileSystem->Print();
 	} else if (!strcmp(*argv, "-t")) {	// performance test
             PerformanceTest();
+	} else if (!strcmp(*argv, "-dt")) {	// disk scheduler test
+            DiskSchedTest();
 	} else if (!strcmp(*argv, "-mkdir")) {	// mkdir a directory file
 	    ASSERT(argc > 1);
 	    Mkdir(*(argv + 1));
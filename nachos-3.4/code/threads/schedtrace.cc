@@ -0,0 +1,292 @@
+// schedtrace.cc
+//	Routines to trace the scheduler, and write the trace out in the
+//	Chrome trace format:
+//
+//		{"traceEvents":[ <event>, <event>, ... ],
+//		 "runQueueLatency":[ <histogram>, ... ]}
+//
+//	Each stretch of time a thread spends running, ready or blocked
+//	is one complete ("X") event on the thread's row; each thread's
+//	row is named by a metadata ("M") event when it first shows up.
+//	Events go out through a TraceWriter (cf. stats.h), which buffers
+//	them.
+//
+//	Names of threads, and of what they block on, are cut short to
+//	TraceNameLength characters, and quoted for JSON.
+//
+// Copyright (c) 1992-1993 The Regents of the University of California.
+// All rights reserved.  See copyright.h for copyright notice and limitation
+// of liability and disclaimer of warranty provisions.
+
+#include "copyright.h"
+#include "schedtrace.h"
+#include "system.h"
+
+//----------------------------------------------------------------------
+// QuoteName
+// 	Copy up to TraceNameLength characters of "name" into "quoted",
+//	which must have room for QuotedNameSize, so that it can go
+//	inside a JSON string: '"' and '\\' are escaped, and control
+//	characters (which would need more) are replaced with '?'.
+//	Returns "quoted".
+//----------------------------------------------------------------------
+
+static char *
+QuoteName(char *name, char *quoted)
+{
+    int n = 0;
+
+    for (int i = 0; i < TraceNameLength && name[i] != '\0'; i++) {
+	if (name[i] == '"' || name[i] == '\\')
+	    quoted[n++] = '\\';
+	quoted[n++] = ((unsigned char) name[i] < ' ') ? '?' : name[i];
+    }
+    quoted[n] = '\0';
+    return quoted;
+}
+
+//----------------------------------------------------------------------
+// ThreadTrace::ThreadTrace
+// 	Start keeping track of "thread", which we have never seen before.
+//	Until we hear otherwise, assume it has been running since the
+//	start of time (true of "main").
+//----------------------------------------------------------------------
+
+ThreadTrace::ThreadTrace(Thread *thread, int num)
+{
+    name = new char[strlen(thread->getName()) + 1];
+    strcpy(name, thread->getName());
+    serial = num;
+    state = thread->getStatus();
+    since = 0;
+    reason = waker = NULL;
+}
+
+//----------------------------------------------------------------------
+// ThreadTrace::~ThreadTrace
+// 	De-allocate what we know about a thread.
+//----------------------------------------------------------------------
+
+ThreadTrace::~ThreadTrace()
+{
+    delete [] name;
+}
+
+//----------------------------------------------------------------------
+// SchedTracer::SchedTracer
+// 	Start a trace in "fileName" (overwriting it if it exists).
+//----------------------------------------------------------------------
+
+SchedTracer::SchedTracer(char *fileName)
+{
+    file = new TraceWriter(fileName);
+    firstEvent = TRUE;
+    threads = new List;
+    numThreads = 0;
+
+    file->Write("{\"traceEvents\":[\n");
+}
+
+//----------------------------------------------------------------------
+// SchedTracer::~SchedTracer
+// 	Finish the trace: close off whatever the current thread is doing,
+//	add the latency histograms, and write it all out.
+//----------------------------------------------------------------------
+
+SchedTracer::~SchedTracer()
+{
+    ThreadTrace *t;
+    char line[100];
+
+    t = Lookup(currentThread);
+    if (t->state == RUNNING)
+	Slice(t, "running", t->since, NULL);
+
+    file->Write("],\n\"runQueueLatency\":[");
+    while ((t = (ThreadTrace *) threads->Remove()) != NULL) {
+	snprintf(line, sizeof(line), "%s\n{\"tid\":%d,\"waits\":%d,"
+			"\"total\":%d,\"max\":%d,\"buckets\":[",
+			t->serial == 1 ? "" : ",", t->serial,
+			t->latency.count, t->latency.total, t->latency.max);
+	file->Write(line);
+	for (int i = 0; i < HistogramBuckets; i++) {
+	    snprintf(line, sizeof(line), "%s%d", i == 0 ? "" : ",",
+						t->latency.buckets[i]);
+	    file->Write(line);
+	}
+	file->Write("]}");
+	delete t;
+    }
+    file->Write("]}\n");
+    delete file;
+    delete threads;
+}
+
+//----------------------------------------------------------------------
+// SchedTracer::Lookup
+// 	Return what we know about "thread", giving it a row in the trace
+//	if this is the first we have seen of it.
+//----------------------------------------------------------------------
+
+ThreadTrace *
+SchedTracer::Lookup(Thread *thread)
+{
+    char event[TraceEventSize];
+    char quoted[QuotedNameSize];
+
+    if (thread->trace == NULL) {
+	thread->trace = new ThreadTrace(thread, ++numThreads);
+	threads->Append((void *)thread->trace);
+	snprintf(event, sizeof(event), "{\"name\":\"thread_name\","
+			"\"ph\":\"M\",\"pid\":0,\"tid\":%d,"
+			"\"args\":{\"name\":\"%s (%d)\"}}",
+			numThreads, QuoteName(thread->getName(), quoted),
+			thread->getTID());
+	Emit(event);
+    }
+    return thread->trace;
+}
+
+//----------------------------------------------------------------------
+// SchedTracer::Ready
+// 	"thread" is going on the ready list: because it is new, because
+//	it was woken up, or because it gave up the CPU while it could
+//	still run.  Close off what it was doing, and start timing its
+//	wait for the CPU.
+//----------------------------------------------------------------------
+
+void
+SchedTracer::Ready(Thread *thread)
+{
+    ThreadTrace *t = Lookup(thread);
+    char args[TraceArgsSize];
+    char reason[QuotedNameSize], waker[QuotedNameSize];
+
+    if (t->state == BLOCKED) {
+	snprintf(args, sizeof(args), "{\"on\":\"%s\",\"woken by\":\"%s\"}",
+		QuoteName(t->reason != NULL ? t->reason : (char *) "?", reason),
+		QuoteName(currentThread->getName(), waker));
+	Slice(t, "blocked", t->since, args);
+    } else if (t->state == RUNNING)
+	Slice(t, "running", t->since, NULL);
+    t->waker = (thread != currentThread) ? currentThread->getName() : NULL;
+    t->state = READY;
+    t->since = stats->totalTicks;
+}
+
+//----------------------------------------------------------------------
+// SchedTracer::Block
+// 	"thread" is about to go to sleep, waiting on "reason".  Callers
+//	that know what the thread is waiting for call this before
+//	Thread::Sleep, which calls it again with a NULL reason; only the
+//	first call counts.
+//----------------------------------------------------------------------
+
+void
+SchedTracer::Block(Thread *thread, char *reason)
+{
+    ThreadTrace *t = Lookup(thread);
+
+    if (t->state == BLOCKED)
+	return;
+    if (t->state == RUNNING)
+	Slice(t, "running", t->since, NULL);
+    t->state = BLOCKED;
+    t->since = stats->totalTicks;
+    t->reason = (thread == threadToBeDestroyed) ? (char *) "finished" : reason;
+}
+
+//----------------------------------------------------------------------
+// SchedTracer::Switch
+// 	The CPU is about to pass from "oldThread" (which has already been
+//	put on the ready list, or blocked) to "nextThread".  Close off the
+//	new thread's wait on the ready list, which goes in its histogram.
+//----------------------------------------------------------------------
+
+void
+SchedTracer::Switch(Thread *oldThread, Thread *nextThread)
+{
+    ThreadTrace *old = Lookup(oldThread);
+    ThreadTrace *next = Lookup(nextThread);
+    int wait = stats->totalTicks - next->since;
+    char args[TraceArgsSize];
+    char waker[QuotedNameSize];
+
+    if (old->state == RUNNING)		// no one told us it stopped
+	Block(oldThread, NULL);
+
+    if (next->waker != NULL)
+	snprintf(args, sizeof(args), "{\"made ready by\":\"%s\"}",
+					QuoteName(next->waker, waker));
+    Slice(next, "ready", next->since, next->waker != NULL ? args : NULL);
+    next->latency.Add(wait);
+
+    next->state = RUNNING;
+    next->since = stats->totalTicks;
+}
+
+//----------------------------------------------------------------------
+// SchedTracer::Slice
+// 	Add an event named "name" to t's row, from "start" until now,
+//	with "args" (a JSON object, or NULL) attached.
+//----------------------------------------------------------------------
+
+void
+SchedTracer::Slice(ThreadTrace *t, char *name, int start, char *args)
+{
+    char event[TraceEventSize];
+
+    snprintf(event, sizeof(event), "{\"name\":\"%s\",\"ph\":\"X\","
+		"\"pid\":0,\"tid\":%d,\"ts\":%d,\"dur\":%d%s%s}",
+		name, t->serial, start, stats->totalTicks - start,
+		args != NULL ? ",\"args\":" : "",
+		args != NULL ? args : "");
+    Emit(event);
+}
+
+//----------------------------------------------------------------------
+// SchedTracer::Emit
+// 	Add one event to the trace, after a comma if it isn't the first.
+//----------------------------------------------------------------------
+
+void
+SchedTracer::Emit(char *event)
+{
+    if (!firstEvent)
+	file->Write(",");
+    firstEvent = FALSE;
+    file->Write(event);
+    file->Write("\n");
+}
+
+//----------------------------------------------------------------------
+// PrintLatency
+// 	Print one thread's run-queue latency: how many times it waited
+//	for the CPU, the mean and worst wait, and a histogram of the
+//	waits, by powers of two.
+//----------------------------------------------------------------------
+
+static void
+PrintLatency(IntPtr arg)
+{
+    ThreadTrace *t = (ThreadTrace *) arg;
+    Histogram *h = &t->latency;
+
+    if (h->count == 0)
+	return;
+    printf("%s (%d): %d waits, mean %d, max %d\n", t->name, t->serial,
+		h->count, h->total / h->count, h->max);
+    h->Print();
+}
+
+//----------------------------------------------------------------------
+// SchedTracer::Print
+// 	Print every thread's run-queue latency, in ticks.
+//----------------------------------------------------------------------
+
+void
+SchedTracer::Print()
+{
+    printf("Run-queue latency, in ticks:\n");
+    threads->Mapcar(PrintLatency);
+}
@@ -0,0 +1,88 @@
+// schedtrace.h
+//	Data structures for tracing the scheduler: every time a thread
+//	becomes ready, starts or stops running, blocks, or is woken up,
+//	in simulated time.
+//
+//	The trace is written as a Chrome trace (JSON, to be loaded into
+//	chrome://tracing or Perfetto), with one row per thread, showing
+//	when it ran, when it sat on the ready list, and when it was
+//	blocked -- and on what.  One tick of simulated time is shown as
+//	one microsecond.
+//
+//	For each thread we also keep a histogram of its run-queue
+//	latency: how long it waited on the ready list each time before
+//	getting the CPU.  The histograms are printed when Nachos halts.
+//
+//	Tracing is off unless Nachos is started with "-tr <file>".
+//
+// Copyright (c) 1992-1993 The Regents of the University of California.
+// All rights reserved.  See copyright.h for copyright notice and limitation
+// of liability and disclaimer of warranty provisions.
+
+#ifndef SCHEDTRACE_H
+#define SCHEDTRACE_H
+
+#include "copyright.h"
+#include "list.h"
+#include "thread.h"
+#include "stats.h"
+
+#define QuotedNameSize	(2 * TraceNameLength + 1)	// room for a name,
+					// with every character escaped
+#define TraceArgsSize	(2 * QuotedNameSize + 40)	// room for the
+					// args of an event
+#define TraceEventSize	(TraceArgsSize + 120)	// room for an event
+
+// The following class defines what the tracer knows about one thread.
+// It outlives the thread, so that the thread's histogram can be
+// printed at the end.
+
+class ThreadTrace {
+  public:
+    ThreadTrace(Thread *thread, int serial);
+    ~ThreadTrace();
+
+    char *name;			// copy of the thread's name
+    int serial;			// row in the trace; unlike TIDs,
+				// these are never reused
+    ThreadStatus state;		// as far as the tracer knows
+    int since;			// when it got into that state
+    char *reason;		// what it is blocked on, if known
+    char *waker;		// who made it ready, if not itself
+
+    Histogram latency;		// ticks it waited to run, each time
+};
+
+// The following class defines the scheduler tracer.  Its routines
+// are called by the scheduler and synchronization routines, with
+// interrupts disabled.
+
+class SchedTracer {
+  public:
+    SchedTracer(char *fileName);	// start a trace in "fileName"
+    ~SchedTracer();			// finish the trace, and close it
+
+    void Ready(Thread *thread);		// thread is going on the ready list
+    void Block(Thread *thread, char *reason);	// thread is going to
+					// sleep, waiting on "reason"
+					// (NULL if not known)
+    void Switch(Thread *oldThread, Thread *nextThread);	// about to
+					// switch from one to the other
+
+    void Print();			// print latency histograms
+
+  private:
+    TraceWriter *file;			// the trace file
+    bool firstEvent;			// no event written yet?
+    List *threads;			// every ThreadTrace, in order
+    int numThreads;
+
+    ThreadTrace *Lookup(Thread *thread);	// find (or start) a
+					// thread's record
+    void Slice(ThreadTrace *t, char *name, int start, char *args);
+					// add an event covering "start"
+					// until now to t's row
+    void Emit(char *event);		// add an event to the trace
+};
+
+#endif // SCHEDTRACE_H
@@ -30,6 +30,10 @@
 Scheduler::Scheduler()
 { 
     readyList = new List; 
+#ifdef USER_PROGRAM
+    registerOwner = NULL;
+    loadedSpace = NULL;
+#endif
 } 
 
 //----------------------------------------------------------------------
@@ -55,10 +59,39 @@ Scheduler::ReadyToRun (Thread *thread)
 {
     DEBUG('t', "Putting thread %s on ready list.\n", thread->getName());
 
+    if (schedTracer != NULL)
+	schedTracer->Ready(thread);
     thread->setStatus(READY);
     readyList->SortedInsert((void *)thread, thread->priority);
 }
 
+//----------------------------------------------------------------------
+// Scheduler::ReadyToRunAll
+// 	Mark every thread on a list as ready, and move them all onto the
+//	ready list, in one pass -- instead of one ReadyToRun (and one walk
+//	down the ready list) per thread.
+//
+//	"threads" is a list of threads, sorted by priority (as if put
+//		there with SortedInsert); it is left empty.
+//----------------------------------------------------------------------
+
+static void
+MarkReady(IntPtr thread)
+{
+    DEBUG('t', "Putting thread %s on ready list.\n",
+				((Thread *) thread)->getName());
+    if (schedTracer != NULL)
+	schedTracer->Ready((Thread *) thread);
+    ((Thread *) thread)->setStatus(READY);
+}
+
+void
+Scheduler::ReadyToRunAll(List *threads)
+{
+    threads->Mapcar(MarkReady);
+    readyList->SortedMerge(threads);
+}
+
 //----------------------------------------------------------------------
 // Scheduler::FindNextToRun
 // 	Return the next thread to be scheduled onto the CPU.
@@ -74,6 +107,24 @@ Scheduler::FindNextToRun ()
     return (Thread*)readyList->SortedRemove(&pp);
 }
 
+//----------------------------------------------------------------------
+// Scheduler::Reprioritize
+// 	The priority of a thread on the ready list has changed (for
+//	instance, because it was donated a higher priority by a thread
+//	waiting for a lock it holds); move it to its new place on the
+//	ready list.
+//
+//	"thread" is the thread whose priority changed; it must be READY.
+//----------------------------------------------------------------------
+
+void
+Scheduler::Reprioritize (Thread *thread)
+{
+    ASSERT(thread->getStatus() == READY);
+    if (readyList->RemoveItem((void *)thread))
+	readyList->SortedInsert((void *)thread, thread->priority);
+}
+
 //----------------------------------------------------------------------
 // Scheduler::Run
 // 	Dispatch the CPU to nextThread.  Save the state of the old thread,
@@ -93,13 +144,10 @@ Scheduler::Run (Thread *nextThread)
 {
     Thread *oldThread = currentThread;
     
-#ifdef USER_PROGRAM			// ignore until running user programs 
-    if (currentThread->space != NULL) {	// if this thread is a user program,
-        currentThread->SaveUserState(); // save the user's CPU registers
-	currentThread->space->SaveState();
-    }
-#endif
-    
+    // The old thread's user registers and page table are left in the
+    // machine; SwitchUserState saves them only if someone else needs
+    // the machine.
+
     oldThread->CheckOverflow();		    // check if the old thread
 					    // had an undetected stack overflow
 
@@ -108,6 +156,8 @@ Scheduler::Run (Thread *nextThread)
     
     DEBUG('t', "Switching from thread \"%s\" to thread \"%s\"\n",
 	  oldThread->getName(), nextThread->getName());
+    if (schedTracer != NULL)
+	schedTracer->Switch(oldThread, nextThread);
     
     // This is a machine-dependent assembly language routine defined 
     // in switch.s.  You may have to think
@@ -122,19 +172,116 @@ Scheduler::Run (Thread *nextThread)
     // we need to delete its carcass.  Note we cannot delete the thread
     // before now (for example, in Thread::Finish()), because up to this
     // point, we were still running on the old thread's stack!
-    if (threadToBeDestroyed != NULL) {
+    // (A finishing thread can be run again itself, if Nachos halts
+    // on its stack and the cleanup has to wait for the disk.)
+    if (threadToBeDestroyed != NULL && threadToBeDestroyed != currentThread) {
         delete threadToBeDestroyed;
 	threadToBeDestroyed = NULL;
     }
     
 #ifdef USER_PROGRAM
-    if (currentThread->space != NULL) {		// if there is an address space
-        currentThread->RestoreUserState();     // to restore, do it.
-	currentThread->space->RestoreState();
-    }
+    SwitchUserState();
 #endif
 }
 
+#ifdef USER_PROGRAM
+//----------------------------------------------------------------------
+// Scheduler::SwitchUserState
+// 	Make the machine ready to run the current thread's user program,
+//	if it has one.  The registers are saved and restored only if
+//	they belong to some other thread, and the page table is loaded
+//	(and the TLB flushed) only if the current thread is in a
+//	different address space -- so switching between two threads
+//	forked within the same user program doesn't touch the TLB.
+//
+//	Threads that only run in the kernel don't use the user state,
+//	so it is left as it is for whichever thread next needs it.
+//----------------------------------------------------------------------
+
+void
+Scheduler::SwitchUserState()
+{
+    AddrSpace *space = currentThread->space;
+
+    if (space == NULL)
+	return;
+    if (registerOwner != currentThread) {
+	if (registerOwner != NULL)
+	    registerOwner->SaveUserState();
+	currentThread->RestoreUserState();
+	registerOwner = currentThread;
+    }
+    LoadAddrSpace(space);
+}
+
+//----------------------------------------------------------------------
+// Scheduler::AdoptUserState
+// 	The current thread is about to start running a user program,
+//	in its own address space or one it shares (see StartProcess
+//	and the Fork system call).  Take the machine registers over
+//	for it, as they stand, saving them for their old owner first;
+//	then load its page table.
+//----------------------------------------------------------------------
+
+void
+Scheduler::AdoptUserState()
+{
+    AddrSpace *space = currentThread->space;
+
+    ASSERT(space != NULL);
+    if (registerOwner != currentThread && registerOwner != NULL)
+	registerOwner->SaveUserState();
+    registerOwner = currentThread;
+    LoadAddrSpace(space);
+}
+
+//----------------------------------------------------------------------
+// Scheduler::LoadAddrSpace
+// 	Load the page table for "space", unless it is already loaded.
+//	The TLB is flushed when the old address space is unloaded.
+//----------------------------------------------------------------------
+
+void
+Scheduler::LoadAddrSpace(AddrSpace *space)
+{
+    if (loadedSpace != space) {
+	if (loadedSpace != NULL)
+	    loadedSpace->SaveState();
+	space->RestoreState();
+	loadedSpace = space;
+    }
+}
+
+//----------------------------------------------------------------------
+// Scheduler::ForgetUserState
+// 	"thread" is being destroyed; if its user registers are in the
+//	machine, there is no need to save them any more.
+//----------------------------------------------------------------------
+
+void
+Scheduler::ForgetUserState(Thread *thread)
+{
+    if (registerOwner == thread)
+	registerOwner = NULL;
+}
+
+//----------------------------------------------------------------------
+// Scheduler::UnloadAddrSpace
+// 	"space" is being destroyed, or some of its pages are being taken
+//	away; if it is loaded, flush it out of the TLB, so that the next
+//	thread to run in it reloads it.
+//----------------------------------------------------------------------
+
+void
+Scheduler::UnloadAddrSpace(AddrSpace *space)
+{
+    if (loadedSpace == space) {
+	space->SaveState();
+	loadedSpace = NULL;
+    }
+}
+#endif
+
 //----------------------------------------------------------------------
 // Scheduler::Print
 // 	Print the scheduler state -- in other words, the contents of
@@ -23,14 +23,40 @@ class Scheduler {
     ~Scheduler();			// De-allocate ready list
 
     void ReadyToRun(Thread* thread);	// Thread can be dispatched.
+    void ReadyToRunAll(List* threads);	// All of a list of threads, sorted
+					// by priority, can be dispatched
     Thread* FindNextToRun();		// Dequeue first thread on the ready 
 					// list, if any, and return thread.
+    void Reprioritize(Thread* thread);	// Move a ready thread to its new
+					// place after its priority changed
     void Run(Thread* nextThread);	// Cause nextThread to start running
     void Print();			// Print contents of ready list
+
+#ifdef USER_PROGRAM
+    void AdoptUserState();		// Give the machine registers, as
+					// they stand, to the current thread
+    void ForgetUserState(Thread* thread);	// "thread" is going away
+    void UnloadAddrSpace(AddrSpace* space);	// Flush "space" out of
+					// the TLB, if it is loaded
+#endif
     
   private:
     List *readyList;  		// queue of threads that are ready to run,
 				// but not running
+
+#ifdef USER_PROGRAM
+// The machine's user registers and page table are switched lazily --
+// they are left alone until a thread that needs them is run.
+
+    Thread *registerOwner;	// thread whose user registers are in the
+				// machine, NULL if none
+    AddrSpace *loadedSpace;	// address space whose page table is
+				// loaded (and whose pages may be in
+				// the TLB), NULL if none
+
+    void SwitchUserState();	// Load the current thread's user state
+    void LoadAddrSpace(AddrSpace *space);	// Load "space"'s page table
+#endif
 };
 
 #endif // SCHEDULER_H
@@ -5,7 +5,8 @@
  *	the registers to be saved, how to set up an initial
  *	call frame, etc, are all specific to a processor architecture.
  *
- * 	This file currently supports the DEC MIPS and SUN SPARC architectures.
+ * 	This file currently supports the DEC MIPS, SUN SPARC, HP PA-RISC,
+ *	Intel 386 and x86-64 architectures.
  */
 
 /*
@@ -152,4 +153,34 @@
 #define StartupPC       %ecx
 #endif
 
+#ifdef HOST_x86_64
+
+/* the offsets of the registers from the beginning of the thread object.
+ * Only the registers the x86-64 calling convention says a function
+ * must preserve (the "callee-saved" registers) need to be saved;
+ * SWITCH is an ordinary function call as far as its caller knows.
+ */
+#define _RSP     0
+#define _RBX     8
+#define _RBP     16
+#define _R12     24
+#define _R13     32
+#define _R14     40
+#define _R15     48
+#define _PC      56
+
+/* These definitions are used in Thread::AllocateStack(). */
+#define PCState         (_PC/8-1)
+#define FPState         (_RBP/8-1)
+#define InitialPCState  (_R12/8-1)
+#define InitialArgState (_R13/8-1)
+#define WhenDonePCState (_R14/8-1)
+#define StartupPCState  (_R15/8-1)
+
+#define InitialPC       %r12
+#define InitialArg      %r13
+#define WhenDonePC      %r14
+#define StartupPC       %r15
+#endif
+
 #endif // SWITCH_H
@@ -10,6 +10,7 @@
  *	    SUN SPARC
  *	    HP PA-RISC
  *	    Intel 386
+ *	    x86-64
  *
  * We define two routines for each architecture:
  *
@@ -342,3 +343,72 @@ SWITCH:
         ret
 
 #endif
+
+#ifdef HOST_x86_64
+
+        .text
+        .align  16
+
+        .globl  ThreadRoot
+
+/* void ThreadRoot( void )
+**
+** expects the following registers to be initialized:
+**      r15     points to startup function (interrupt enable)
+**      r13     contains inital argument to thread function
+**      r12     points to thread function
+**      r14     point to Thread::Finish()
+**
+** The stack is re-aligned to 16 bytes, as the calling convention
+** requires at each call.
+*/
+ThreadRoot:
+        pushq   %rbp
+        movq    %rsp,%rbp
+        andq    $-16,%rsp
+        call    *StartupPC
+        movq    InitialArg,%rdi
+        call    *InitialPC
+        call    *WhenDonePC
+
+        // NOT REACHED
+        movq    %rbp,%rsp
+        popq    %rbp
+        ret
+
+
+/* void SWITCH( thread *t1, thread *t2 )
+**
+** on entry, rdi points to t1, rsi points to t2, and
+**       (rsp)  ->              return address
+**
+** Only the callee-saved registers are saved and restored; the
+** caller of SWITCH has already saved anything else it needs.
+*/
+        .globl  SWITCH
+SWITCH:
+        movq    %rsp,_RSP(%rdi)         # save stack pointer
+        movq    %rbx,_RBX(%rdi)         # save registers
+        movq    %rbp,_RBP(%rdi)
+        movq    %r12,_R12(%rdi)
+        movq    %r13,_R13(%rdi)
+        movq    %r14,_R14(%rdi)
+        movq    %r15,_R15(%rdi)
+        movq    0(%rsp),%rax            # get return address from stack
+        movq    %rax,_PC(%rdi)          # save it into the pc storage
+
+        movq    _RSP(%rsi),%rsp         # restore stack pointer
+        movq    _RBX(%rsi),%rbx         # restore registers
+        movq    _RBP(%rsi),%rbp
+        movq    _R12(%rsi),%r12
+        movq    _R13(%rsi),%r13
+        movq    _R14(%rsi),%r14
+        movq    _R15(%rsi),%r15
+        movq    _PC(%rsi),%rax          # restore return address
+        movq    %rax,0(%rsp)            # copy it over the one on the stack
+
+        ret
+
+        .section .note.GNU-stack,"",@progbits
+
+#endif
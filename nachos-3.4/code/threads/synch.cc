@@ -1,8 +1,7 @@
 // synch.cc 
 //	Routines for synchronizing threads.  Three kinds of
 //	synchronization routines are defined here: semaphores, locks 
-//   	and condition variables (the implementation of the last two
-//	are left to the reader).
+//   	and condition variables.
 //
 // Any implementation of a synchronization routine needs some
 // primitive atomic operation.  We assume Nachos is running on
@@ -68,6 +67,8 @@ Semaphore::P()
     
     while (value == 0) { 			// semaphore not available
 	queue->Append((void *)currentThread);	// so go to sleep
+	if (schedTracer != NULL)
+	    schedTracer->Block(currentThread, name);
 	currentThread->Sleep();
     } 
     value--; 					// semaphore available, 
@@ -96,138 +97,811 @@ Semaphore::V()
     value++;
     (void) interrupt->SetLevel(oldLevel);
 }
-// Dummy functions -- so we can compile our later assignments 
-// Note -- without a correct implementation of Condition::Wait(), 
-// the test case in the network assignment won't work!
-Lock::Lock(char* debugName) {
-	name = debugName;
-	lock = new Semaphore("lock semaphore", 1);
+//----------------------------------------------------------------------
+// Lock::Lock
+// 	Initialize a lock, so that it can be used for synchronization.
+//	The lock starts out FREE.
+//
+//	"debugName" is an arbitrary name, useful for debugging.
+//----------------------------------------------------------------------
+
+Lock::Lock(char* debugName)
+{
+    name = debugName;
+    holdingThread = NULL;
+    nextHeld = NULL;
+    queue = new List;
+    numWaiting = 0;
+    keepStats = FALSE;
+    numAcquires = numContended = waitTicks = maxWaiting = 0;
 }
-Lock::~Lock() {delete lock;}
-void Lock::Acquire() {
-	lock->P();
+
+//----------------------------------------------------------------------
+// Lock::~Lock
+// 	De-allocate lock, when no longer needed.  Assume no one
+//	is still waiting on the lock!
+//----------------------------------------------------------------------
+
+Lock::~Lock()
+{
+    ASSERT(queue->IsEmpty());
+    delete queue;
+}
+
+//----------------------------------------------------------------------
+// Lock::AddHeld, Lock::RemoveHeld
+// 	Add this lock to, or remove it from, the chain of locks held by
+//	"thread".  Thread::UpdatePriority walks the chain to find out
+//	what priority has been donated to the thread.
+//----------------------------------------------------------------------
+
+void
+Lock::AddHeld(Thread *thread)
+{
+    nextHeld = thread->heldLocks;
+    thread->heldLocks = this;
+}
+
+void
+Lock::RemoveHeld(Thread *thread)
+{
+    Lock **ptr;
+
+    for (ptr = &thread->heldLocks; *ptr != this; ptr = &(*ptr)->nextHeld)
+	ASSERT(*ptr != NULL);
+    *ptr = nextHeld;
+    nextHeld = NULL;
+}
+
+//----------------------------------------------------------------------
+// Lock::Acquire
+// 	Wait until the lock is FREE, then make the current thread its
+//	holder.  While waiting, we donate our priority to the holder.
+//
+//	As with Semaphore::P, this must be atomic, so interrupts are
+//	disabled throughout.
+//----------------------------------------------------------------------
+
+void
+Lock::Acquire()
+{
+    IntStatus oldLevel = interrupt->SetLevel(IntOff);
+
+    ASSERT(!isHeldByCurrentThread());		// locks aren't recursive
+    if (holdingThread == NULL) {		// lock is FREE, take it
 	holdingThread = currentThread;
+	AddHeld(currentThread);
+    } else {					// lock is BUSY, wait
+	int startTicks = stats->totalTicks;
+
+	DEBUG('t', "Thread \"%s\" waiting for lock \"%s\" held by \"%s\"\n",
+		currentThread->getName(), name, holdingThread->getName());
+	currentThread->waitingOn = this;
+	queue->SortedInsert((void *)currentThread, currentThread->priority);
+	numWaiting++;
+	if (keepStats && numWaiting > maxWaiting)
+	    maxWaiting = numWaiting;
+	holdingThread->UpdatePriority();	// donate our priority
+
+	while (holdingThread != currentThread) {	// Release hands it to us
+	    if (schedTracer != NULL)
+		schedTracer->Block(currentThread, name);
+	    currentThread->Sleep();
+	}
+
+	if (keepStats) {
+	    numContended++;
+	    waitTicks += stats->totalTicks - startTicks;
+	}
+    }
+    if (keepStats)
+	numAcquires++;
+    (void) interrupt->SetLevel(oldLevel);
 }
-bool Lock::isHeldByCurrentThread()
+
+//----------------------------------------------------------------------
+// Lock::Release
+// 	Set the lock FREE, or rather, hand it directly to the most urgent
+//	waiter, if there is one.  Any priority that was donated to us
+//	through this lock is given back.  If the new holder is now more
+//	urgent than we are, let it run right away -- unless we were
+//	called with interrupts off, in which case the caller (for
+//	instance, Condition::Wait) is about to give up the CPU anyway.
+//
+//	Only the holder of the lock may release it.
+//----------------------------------------------------------------------
+
+void
+Lock::Release()
 {
-	if(holdingThread == currentThread)
-		return true;
-	return false;
+    IntStatus oldLevel = interrupt->SetLevel(IntOff);
+    Thread *next;
+
+    ASSERT(isHeldByCurrentThread());
+    RemoveHeld(currentThread);
+
+    next = (Thread *)queue->Remove();
+    holdingThread = next;
+    if (next != NULL) {
+	numWaiting--;
+	next->waitingOn = NULL;
+	AddHeld(next);
+	next->UpdatePriority();		// inherit from the other waiters
+	scheduler->ReadyToRun(next);
+    }
+    currentThread->UpdatePriority();	// give back donated priority
+
+    if (oldLevel == IntOn && next != NULL
+			&& next->priority < currentThread->priority)
+	currentThread->Yield();
+    (void) interrupt->SetLevel(oldLevel);
 }
-void Lock::Release() {
-	if(Lock::isHeldByCurrentThread())
-		lock->V();
+
+//----------------------------------------------------------------------
+// Lock::isHeldByCurrentThread
+// 	Return TRUE if the current thread holds the lock.
+//----------------------------------------------------------------------
+
+bool
+Lock::isHeldByCurrentThread()
+{
+    return (holdingThread == currentThread);
 }
 
-Condition::Condition(char* debugName) {
-	name = debugName;
-	condition = new Semaphore("conditon semaphore", 0);
-	waitingNumber = 0;
+//----------------------------------------------------------------------
+// Lock::WaiterPriority
+// 	Return the priority of the most urgent thread waiting for the
+//	lock, or NoWaiterPriority if no one is waiting.
+//----------------------------------------------------------------------
+
+int
+Lock::WaiterPriority()
+{
+    int p;
+
+    if (queue->Front(&p) == NULL)
+	return NoWaiterPriority;
+    return p;
 }
-Condition::~Condition() {delete condition; }
-void Condition::Wait(Lock* conditionLock) { 
-	ASSERT(FALSE);
-	waitingNumber ++;
-	conditionLock->Release();
-	condition->P();
-	conditionLock->Acquire();	
+
+//----------------------------------------------------------------------
+// Lock::Reprioritize
+// 	The priority of a thread waiting for the lock has changed; move
+//	it to its new place in the queue, and pass the change on to the
+//	holder.  Called by Thread::UpdatePriority, with interrupts
+//	disabled.
+//
+//	"thread" is the waiter whose priority changed.
+//----------------------------------------------------------------------
+
+void
+Lock::Reprioritize(Thread *thread)
+{
+    if (queue->RemoveItem((void *)thread))
+	queue->SortedInsert((void *)thread, thread->priority);
+    if (holdingThread != NULL)
+	holdingThread->UpdatePriority();
 }
-void Condition::Signal(Lock* conditionLock) { 
-	if(waitingNumber > 0)
-	{
-		condition->V();
-		waitingNumber --;
-	}
+
+//----------------------------------------------------------------------
+// Lock::EnableStats, Lock::PrintStats
+// 	Start keeping track of how contended the lock is, and print
+//	what has been gathered so far.  Wait times are in simulated ticks.
+//----------------------------------------------------------------------
+
+void
+Lock::EnableStats()
+{
+    keepStats = TRUE;
 }
-void Condition::Broadcast(Lock* conditionLock) {
-	while(waitingNumber > 0)
-	{
-		condition->V();
-		waitingNumber --;
-	}
+
+void
+Lock::PrintStats()
+{
+    printf("Lock \"%s\": %d acquires, %d contended, ", name,
+					numAcquires, numContended);
+    printf("%d ticks waiting, max queue length %d\n", waitTicks,
+					maxWaiting);
 }
 
-Barrier::Barrier()
+//----------------------------------------------------------------------
+// Condition::Condition
+// 	Initialize a condition variable, with no one waiting on it.
+//	Waiters are woken in FIFO order unless SetOrder says otherwise.
+//
+//	"debugName" is an arbitrary name, useful for debugging.
+//----------------------------------------------------------------------
+
+Condition::Condition(char* debugName)
 {
-	expectedNum = 0;
-	arrivedNum = 0;
-	s = new Semaphore("Barrier Semaphore", 0);
-	mutex = new Semaphore("Mutex Semaphore", 1);
+    name = debugName;
+    queue = new List;
+    order = WaitFifo;
+}
+
+//----------------------------------------------------------------------
+// Condition::~Condition
+// 	De-allocate the condition variable.  Assume no one is still
+//	waiting on it!
+//----------------------------------------------------------------------
+
+Condition::~Condition()
+{
+    ASSERT(queue->IsEmpty());
+    delete queue;
+}
+
+//----------------------------------------------------------------------
+// Condition::Wait
+// 	Release "conditionLock", wait until signaled, then re-acquire it.
+//
+//	Putting ourselves on the wait queue and releasing the lock are
+//	done with interrupts disabled, so no Signal can slip in between
+//	them and be lost.  Lock::Release won't yield the CPU when called
+//	with interrupts already off, so we are not on the ready list
+//	when we go to sleep.
+//----------------------------------------------------------------------
+
+void
+Condition::Wait(Lock* conditionLock)
+{
+    IntStatus oldLevel = interrupt->SetLevel(IntOff);
+
+    ASSERT(conditionLock->isHeldByCurrentThread());
+    if (order == WaitPriority)
+	queue->SortedInsert((void *)currentThread, currentThread->priority);
+    else
+	queue->Append((void *)currentThread);
+    conditionLock->Release();
+    if (schedTracer != NULL)
+	schedTracer->Block(currentThread, name);
+    currentThread->Sleep();
+    (void) interrupt->SetLevel(oldLevel);
+
+    conditionLock->Acquire();
+}
+
+//----------------------------------------------------------------------
+// Condition::Signal
+// 	Wake up the first thread waiting on the condition, if there
+//	is one, by moving it straight to the ready list.
+//----------------------------------------------------------------------
+
+void
+Condition::Signal(Lock* conditionLock)
+{
+    IntStatus oldLevel = interrupt->SetLevel(IntOff);
+    Thread *thread;
+
+    ASSERT(conditionLock->isHeldByCurrentThread());
+    thread = (Thread *)queue->Remove();
+    if (thread != NULL)
+	scheduler->ReadyToRun(thread);
+    (void) interrupt->SetLevel(oldLevel);
+}
+
+//----------------------------------------------------------------------
+// Condition::Broadcast
+// 	Wake up every thread waiting on the condition.
+//----------------------------------------------------------------------
+
+void
+Condition::Broadcast(Lock* conditionLock)
+{
+    IntStatus oldLevel = interrupt->SetLevel(IntOff);
+    Thread *thread;
+
+    ASSERT(conditionLock->isHeldByCurrentThread());
+    while ((thread = (Thread *)queue->Remove()) != NULL)
+	scheduler->ReadyToRun(thread);
+    (void) interrupt->SetLevel(oldLevel);
+}
+
+//----------------------------------------------------------------------
+// Barrier::Barrier
+// 	Initialize a barrier, so that it can be used for synchronization.
+//
+//	"debugName" is an arbitrary name, useful for debugging.
+//	"num" is the number of threads that must meet at the barrier.
+//----------------------------------------------------------------------
+
+Barrier::Barrier(char* debugName, int num)
+{
+    name = debugName;
+    expectedNum = num;
+    arrivedNum = 0;
+    sense = FALSE;
+    phase = 0;
+    queue = new List;
+    action = NULL;
+    actionArg = 0;
 }
 
+//----------------------------------------------------------------------
+// Barrier::~Barrier
+// 	De-allocate the barrier.  Assume no one is still waiting on it!
+//----------------------------------------------------------------------
+
 Barrier::~Barrier()
 {
-	delete s;
+    ASSERT(queue->IsEmpty());
+    delete queue;
 }
 
-void Barrier::setBarrier(int num)
+//----------------------------------------------------------------------
+// Barrier::setBarrier
+// 	Change the number of threads that must meet at the barrier.
+//	Only allowed between phases, with no one waiting.
+//----------------------------------------------------------------------
+
+void
+Barrier::setBarrier(int num)
 {
-	mutex->P();
+    IntStatus oldLevel = interrupt->SetLevel(IntOff);
+
+    ASSERT(arrivedNum == 0 && num > 0);
+    expectedNum = num;
+    (void) interrupt->SetLevel(oldLevel);
+}
+
+//----------------------------------------------------------------------
+// Barrier::setAction
+// 	Have the last thread to arrive at the barrier call "func(arg)",
+//	in every phase, before anyone is released.  "func" is NULL for
+//	no action.
+//----------------------------------------------------------------------
+
+void
+Barrier::setAction(VoidFunctionPtr func, IntPtr arg)
+{
+    action = func;
+    actionArg = arg;
+}
+
+//----------------------------------------------------------------------
+// Barrier::waitOnBarrier
+// 	Wait until all the threads have arrived at the barrier.  The last
+//	one to arrive runs the action, ends the phase by flipping "sense",
+//	and wakes all the others together.
+//
+//	The waiters are kept sorted by priority, so that they can be
+//	merged onto the ready list in one pass.
+//
+//	Returns TRUE in the last thread to arrive, FALSE in the others.
+//----------------------------------------------------------------------
+
+bool
+Barrier::waitOnBarrier()
+{
+    IntStatus oldLevel = interrupt->SetLevel(IntOff);
+    bool mySense = !sense;		// what "sense" will be when this
+					// phase is over
+    bool isLast = FALSE;
+
+    arrivedNum++;
+    if (arrivedNum == expectedNum) {
+	DEBUG('t', "Barrier \"%s\" phase %d complete\n", name, phase);
+	if (action != NULL) {
+	    (void) interrupt->SetLevel(oldLevel); // everyone else is asleep
+	    (*action)(actionArg);
+	    (void) interrupt->SetLevel(IntOff);
+	}
 	arrivedNum = 0;
-	expectedNum = num;
-	mutex->V();
+	phase++;
+	sense = mySense;
+	scheduler->ReadyToRunAll(queue);
+	isLast = TRUE;
+    } else {
+	while (sense != mySense) {
+	    queue->SortedInsert((void *)currentThread, currentThread->priority);
+	    currentThread->Sleep();
+	}
+    }
+    (void) interrupt->SetLevel(oldLevel);
+    return isLast;
 }
 
-void Barrier::waitOnBarrier()
+//----------------------------------------------------------------------
+// TreeBarrier::TreeBarrier
+// 	Initialize a tree-structured barrier.  The leaves each take
+//	"fanIn" threads (the last one may take fewer); each level above
+//	takes "fanIn" nodes from the level below, up to a single root.
+//
+//	"debugName" is an arbitrary name, useful for debugging.
+//	"num" is the number of threads that must meet at the barrier.
+//	"fanIn" is the most threads (or nodes) that meet at any node.
+//----------------------------------------------------------------------
+
+TreeBarrier::TreeBarrier(char* debugName, int num, int numPerNode)
 {
-	mutex->P();
-	arrivedNum++;
-	if(arrivedNum == expectedNum)
-	{
-		mutex->V();
-		for(int i = 0; i < expectedNum - 1; i++) {
-			s->V();
-		}
+    int levelStart, levelSize, nextSize, i;
+
+    ASSERT(num > 0 && numPerNode > 1);
+    name = debugName;
+    numThreads = num;
+    fanIn = numPerNode;
+    sense = FALSE;
+    phase = 0;
+    action = NULL;
+    actionArg = 0;
+
+    numNodes = 0;				// count the nodes first
+    depth = 0;
+    for (levelSize = num; ; levelSize = nextSize) {
+	nextSize = divRoundUp(levelSize, fanIn);
+	numNodes += nextSize;
+	depth++;
+	if (nextSize == 1)
+	    break;
+    }
+    ASSERT(depth <= MaxBarrierDepth);
+
+    nodes = new BarrierNode[numNodes];
+    levelStart = 0;
+    for (levelSize = num; ; levelSize = nextSize) {
+	nextSize = divRoundUp(levelSize, fanIn);
+	for (i = 0; i < nextSize; i++) {
+	    BarrierNode *node = &nodes[levelStart + i];
+
+	    node->expectedNum = min(fanIn, levelSize - i * fanIn);
+	    node->arrivedNum = 0;
+	    node->queue = new List;
+	    if (nextSize == 1)
+		node->parent = NULL;		// the root
+	    else
+		node->parent = &nodes[levelStart + nextSize + i / fanIn];
+	}
+	if (nextSize == 1)
+	    break;
+	levelStart += nextSize;
+    }
+}
+
+//----------------------------------------------------------------------
+// TreeBarrier::~TreeBarrier
+// 	De-allocate the barrier.  Assume no one is still waiting on it!
+//----------------------------------------------------------------------
+
+TreeBarrier::~TreeBarrier()
+{
+    for (int i = 0; i < numNodes; i++) {
+	ASSERT(nodes[i].queue->IsEmpty());
+	delete nodes[i].queue;
+    }
+    delete [] nodes;
+}
+
+//----------------------------------------------------------------------
+// TreeBarrier::setAction
+// 	Have the last thread to arrive at the barrier call "func(arg)",
+//	in every phase, before anyone is released.  "func" is NULL for
+//	no action.
+//----------------------------------------------------------------------
+
+void
+TreeBarrier::setAction(VoidFunctionPtr func, IntPtr arg)
+{
+    action = func;
+    actionArg = arg;
+}
+
+//----------------------------------------------------------------------
+// TreeBarrier::waitOnBarrier
+// 	Wait until all the threads have arrived at the barrier.
+//
+//	Climb the tree from our leaf for as long as we are the last to
+//	arrive at each node, remembering the nodes we passed through;
+//	stop at the first node where someone is still to come, and wait
+//	there.  Whoever gets past the root ends the phase.  Then, once we
+//	are released (or ended the phase ourselves), release the threads
+//	waiting at the nodes we passed through, from the top down.
+//
+//	Returns TRUE in the last thread to arrive, FALSE in the others.
+//
+//	"which" is this thread's number, from 0 to num - 1.
+//----------------------------------------------------------------------
+
+bool
+TreeBarrier::waitOnBarrier(int which)
+{
+    IntStatus oldLevel = interrupt->SetLevel(IntOff);
+    BarrierNode *passed[MaxBarrierDepth];	// nodes we were last to reach
+    int numPassed = 0;
+    BarrierNode *node = &nodes[which / fanIn];
+    bool mySense = !sense;
+    bool isLast = FALSE;
+
+    ASSERT(which >= 0 && which < numThreads);
+    for (;;) {
+	node->arrivedNum++;
+	if (node->arrivedNum < node->expectedNum) {
+	    while (sense != mySense) {		// wait to be released
+		node->queue->SortedInsert((void *)currentThread,
+						currentThread->priority);
+		currentThread->Sleep();
+	    }
+	    break;
 	}
-	else
-	{
-		mutex->V();
-		s->P();
+	node->arrivedNum = 0;			// last one here
+	passed[numPassed++] = node;
+	if (node->parent == NULL) {		// last one anywhere
+	    DEBUG('t', "Barrier \"%s\" phase %d complete\n", name, phase);
+	    if (action != NULL) {
+		(void) interrupt->SetLevel(oldLevel);
+		(*action)(actionArg);
+		(void) interrupt->SetLevel(IntOff);
+	    }
+	    phase++;
+	    sense = mySense;
+	    isLast = TRUE;
+	    break;
 	}
+	node = node->parent;
+    }
+    while (numPassed > 0)			// release our subtree
+	scheduler->ReadyToRunAll(passed[--numPassed]->queue);
+    (void) interrupt->SetLevel(oldLevel);
+    return isLast;
 }
 
+// The following class defines one thread waiting in a ReadWriteLock.
+// It lives on the waiting thread's stack, while it sleeps.
+
+class RWWaiter {
+  public:
+    Thread *thread;		// the waiting thread
+    bool isWriter;		// waiting to write, or to read?
+    bool admitted;		// set when the thread is let in
+};
+
+//----------------------------------------------------------------------
+// ReadWriteLock::ReadWriteLock
+// 	Initialize a reader/writer lock, with no one holding it.
+//----------------------------------------------------------------------
+
 ReadWriteLock::ReadWriteLock()
 {
-	mutex = new Lock("Mutex Lock");
-	w = new Lock("write Lock");
-	r = new Lock("Read Lock");
-	rc = 0;
+	queue = new List;
+	readers = 0;
+	writer = NULL;
+	upgrader = NULL;
+	waitingWriters = 0;
+	preference = PreferWriters;
 }
 
+//----------------------------------------------------------------------
+// ReadWriteLock::~ReadWriteLock
+// 	De-allocate the lock.  Assume no one is holding or waiting on it!
+//----------------------------------------------------------------------
+
 ReadWriteLock::~ReadWriteLock()
 {
-	delete mutex;
-	delete w;
-	delete r;
+	ASSERT(queue->IsEmpty());
+	delete queue;
+}
+
+//----------------------------------------------------------------------
+// ReadWriteLock::ReaderMayEnter
+// 	Return TRUE if a reader may get in right now: no one is writing
+//	or upgrading, and (if we prefer writers) no writer is waiting.
+//----------------------------------------------------------------------
+
+bool
+ReadWriteLock::ReaderMayEnter()
+{
+	if (writer != NULL || upgrader != NULL)
+		return FALSE;
+	return (preference == PreferReaders || waitingWriters == 0);
+}
+
+//----------------------------------------------------------------------
+// ReadWriteLock::AdmitReaders
+// 	Let in every reader on the wait queue, in one batch, leaving
+//	the writers in the queue in the same order.  Return the number
+//	of readers let in.  Called with interrupts disabled.
+//----------------------------------------------------------------------
+
+int
+ReadWriteLock::AdmitReaders()
+{
+	List *stillWaiting = new List;
+	RWWaiter *w;
+	int n = 0;
+
+	while ((w = (RWWaiter *)queue->Remove()) != NULL) {
+		if (w->isWriter) {
+			stillWaiting->Append((void *)w);
+		} else {
+			readers++;
+			n++;
+			w->admitted = TRUE;
+			scheduler->ReadyToRun(w->thread);
+		}
+	}
+	delete queue;
+	queue = stillWaiting;
+	return n;
+}
+
+//----------------------------------------------------------------------
+// ReadWriteLock::AdmitWriter
+// 	Let in the first writer on the wait queue, if there is one.
+//	Called with interrupts disabled, when no one holds the lock.
+//----------------------------------------------------------------------
+
+void
+ReadWriteLock::AdmitWriter()
+{
+	List *stillWaiting = new List;
+	RWWaiter *w;
+
+	while ((w = (RWWaiter *)queue->Remove()) != NULL) {
+		if (w->isWriter && writer == NULL) {
+			writer = w->thread;
+			waitingWriters--;
+			w->admitted = TRUE;
+			scheduler->ReadyToRun(w->thread);
+		} else {
+			stillWaiting->Append((void *)w);
+		}
+	}
+	delete queue;
+	queue = stillWaiting;
+}
+
+//----------------------------------------------------------------------
+// ReadWriteLock::Wakeup
+// 	Something changed; let in whoever may enter now.  A pending
+//	upgrade goes first, as soon as the upgrader is the only reader
+//	left.  Otherwise waiting readers go in as a batch if the
+//	preference allows, and failing that, one writer goes in if
+//	the lock is free.  Called with interrupts disabled.
+//----------------------------------------------------------------------
+
+void
+ReadWriteLock::Wakeup()
+{
+	if (writer != NULL)
+		return;
+	if (upgrader != NULL) {
+		if (readers == 1) {		// only the upgrader is left
+			readers = 0;
+			writer = upgrader;
+			upgrader = NULL;
+			waitingWriters--;
+			scheduler->ReadyToRun(writer);
+		}
+		return;
+	}
+	if (ReaderMayEnter() && AdmitReaders() > 0)
+		return;
+	if (readers == 0)
+		AdmitWriter();
 }
 
+//----------------------------------------------------------------------
+// ReadWriteLock::prepareToRead
+// 	Wait until we may read, then join the readers.
+//----------------------------------------------------------------------
+
 void ReadWriteLock::prepareToRead()
 {
-	r->Acquire();
-	mutex->Acquire();
-	rc++;
-	if(rc == 1)
-		w->Acquire();
-	mutex->Release();
-	r->Release();
+	IntStatus oldLevel = interrupt->SetLevel(IntOff);
+
+	if (ReaderMayEnter()) {
+		readers++;
+	} else {
+		RWWaiter w;
+
+		w.thread = currentThread;
+		w.isWriter = FALSE;
+		w.admitted = FALSE;
+		queue->Append((void *)&w);
+		while (!w.admitted)		// AdmitReaders counts us in
+			currentThread->Sleep();
+	}
+	(void) interrupt->SetLevel(oldLevel);
 }
-	
+
+//----------------------------------------------------------------------
+// ReadWriteLock::finishRead
+// 	Leave the readers; the last one out lets in a writer, or the
+//	upgrader.
+//----------------------------------------------------------------------
+
 void ReadWriteLock::finishRead()
 {
-	mutex->Acquire();
-	rc--;
-	if(rc == 0)
-		w->Release();
-	mutex->Release();
+	IntStatus oldLevel = interrupt->SetLevel(IntOff);
+
+	ASSERT(readers > 0);
+	readers--;
+	Wakeup();
+	(void) interrupt->SetLevel(oldLevel);
 }
+
+//----------------------------------------------------------------------
+// ReadWriteLock::prepareToWrite
+// 	Wait until no one else holds the lock, then take it for writing.
+//----------------------------------------------------------------------
+
 void ReadWriteLock::prepareToWrite()
 {
-	r->Acquire();
-	w->Acquire();
-	r->Release();
+	IntStatus oldLevel = interrupt->SetLevel(IntOff);
+
+	ASSERT(writer != currentThread);
+	if (writer == NULL && upgrader == NULL && readers == 0
+						&& queue->IsEmpty()) {
+		writer = currentThread;
+	} else {
+		RWWaiter w;
+
+		w.thread = currentThread;
+		w.isWriter = TRUE;
+		w.admitted = FALSE;
+		waitingWriters++;
+		queue->Append((void *)&w);
+		while (!w.admitted)		// AdmitWriter makes us writer
+			currentThread->Sleep();
+	}
+	(void) interrupt->SetLevel(oldLevel);
 }
+
+//----------------------------------------------------------------------
+// ReadWriteLock::finishWrite
+// 	Give up the write lock, letting in the next writer or a batch
+//	of readers.
+//----------------------------------------------------------------------
+
 void ReadWriteLock::finishWrite()
 {
-	w->Release();
+	IntStatus oldLevel = interrupt->SetLevel(IntOff);
+
+	ASSERT(writer == currentThread);
+	writer = NULL;
+	Wakeup();
+	(void) interrupt->SetLevel(oldLevel);
+}
+
+//----------------------------------------------------------------------
+// ReadWriteLock::upgradeToWrite
+// 	Turn our read lock into a write lock, waiting for the other
+//	readers to finish first.  No new readers get in meanwhile.
+//	Two readers upgrading at once would wait for each other
+//	forever, so that isn't allowed.
+//----------------------------------------------------------------------
+
+void ReadWriteLock::upgradeToWrite()
+{
+	IntStatus oldLevel = interrupt->SetLevel(IntOff);
+
+	ASSERT(readers > 0 && writer == NULL);
+	ASSERT(upgrader == NULL);
+	if (readers == 1) {			// we are the only reader
+		readers = 0;
+		writer = currentThread;
+	} else {
+		upgrader = currentThread;
+		waitingWriters++;
+		while (writer != currentThread)	// last reader out lets us in
+			currentThread->Sleep();
+	}
+	(void) interrupt->SetLevel(oldLevel);
 }
 
+//----------------------------------------------------------------------
+// ReadWriteLock::downgradeToRead
+// 	Turn our write lock into a read lock, letting in any waiting
+//	readers along with us (unless a writer is waiting, and we
+//	prefer writers).
+//----------------------------------------------------------------------
+
+void ReadWriteLock::downgradeToRead()
+{
+	IntStatus oldLevel = interrupt->SetLevel(IntOff);
+
+	ASSERT(writer == currentThread);
+	writer = NULL;
+	readers = 1;
+	Wakeup();
+	(void) interrupt->SetLevel(oldLevel);
+}
@@ -2,10 +2,8 @@
 //	Data structures for synchronizing threads.
 //
 //	Three kinds of synchronization are defined here: semaphores,
-//	locks, and condition variables.  The implementation for
-//	semaphores is given; for the latter two, only the procedure
-//	interface is given -- they are to be implemented as part of 
-//	the first assignment.
+//	locks, and condition variables, plus barriers and reader/writer
+//	locks built on top of them.
 //
 //	Note that all the synchronization objects take a "name" as
 //	part of the initialization.  This is solely for debugging purposes.
@@ -60,14 +58,24 @@ class Semaphore {
 //	Release -- set lock to be FREE, waking up a thread waiting
 //		in Acquire if necessary
 //
-// In addition, by convention, only the thread that acquired the lock
-// may release it.  As with semaphores, you can't read the lock value
+// In addition, only the thread that acquired the lock may release it.
+// As with semaphores, you can't read the lock value
 // (because the value might change immediately after you read it).  
+//
+// Waiting threads are queued by priority, and a thread waiting for
+// the lock donates its priority to the holder (and, if the holder is
+// itself waiting for a lock, to that lock's holder, and so on), so
+// that a low priority holder can't hold up a high priority waiter
+// indefinitely.  On Release, the lock is handed directly to the most
+// urgent waiter.
+
+#define NoWaiterPriority	0x7fffffff	// WaiterPriority, when
+						// no one is waiting
 
 class Lock {
   public:
-    Semaphore *lock;
-    Thread *holdingThread;
+    Thread *holdingThread;		// NULL if the lock is FREE
+    Lock *nextHeld;			// next lock held by holdingThread
     Lock(char* debugName);  		// initialize lock to be FREE
     ~Lock();				// deallocate lock
     char* getName() { return name; }	// debugging assist
@@ -80,9 +88,27 @@ class Lock {
 					// checking in Release, and in
 					// Condition variable ops below.
 
+    int WaiterPriority();		// priority of the most urgent
+					// waiter, NoWaiterPriority if none
+    void Reprioritize(Thread *thread);	// a waiter's priority changed
+
+    void EnableStats();			// start keeping contention stats
+    void PrintStats();			// print them
+
   private:
     char* name;				// for debugging
-    // plus some other stuff you'll need to define
+    List *queue;			// threads waiting in Acquire,
+					// sorted by priority
+    int numWaiting;			// # of threads on "queue"
+
+    void AddHeld(Thread *thread);	// put us on thread's held locks
+    void RemoveHeld(Thread *thread);	// take us off them
+
+    bool keepStats;			// are the following being kept?
+    int numAcquires;			// # of times acquired
+    int numContended;			// # of those that had to wait
+    int waitTicks;			// total ticks spent waiting
+    int maxWaiting;			// longest "queue" has been
 };
 
 // The following class defines a "condition variable".  A condition
@@ -116,15 +142,20 @@ class Lock {
 // The consequence of using Mesa-style semantics is that some other thread
 // can acquire the lock, and change data structures, before the woken
 // thread gets a chance to run.
+//
+// Waiters are woken in the order they called Wait (WaitFifo, the
+// default), or most urgent first (WaitPriority), by the priority they
+// had when they called Wait.
+
+enum WaitOrder { WaitFifo, WaitPriority };
 
 class Condition {
   public:
-    Semaphore *condition;
-    int waitingNumber;
     Condition(char* debugName);		// initialize condition to 
 					// "no one waiting"
     ~Condition();			// deallocate the condition
     char* getName() { return (name); }
+    void SetOrder(WaitOrder o) { order = o; }	// who Signal wakes first
     
     void Wait(Lock *conditionLock); 	// these are the 3 operations on 
 					// condition variables; releasing the 
@@ -136,35 +167,154 @@ class Condition {
 
   private:
     char* name;
-    // plus some other stuff you'll need to define
+    List *queue;			// threads waiting in Wait()
+    WaitOrder order;			// how "queue" is kept
 };
 
+// The following class defines a barrier -- a meeting point for a fixed
+// number of threads.  Each thread that calls waitOnBarrier waits until
+// all of them have; then they all go on, and the barrier is ready for
+// the next "phase".
+//
+// The barrier is "sense-reversing": each phase flips a flag, and a
+// waiting thread goes on once the flag no longer matches the phase
+// it arrived in.  So the barrier can be used phase after phase
+// without being reset, even if a fast thread gets back to it before
+// a slow one has left.
+//
+// The last thread to arrive runs an optional "action" before anyone
+// is released (for instance, to check or set up the next phase), and
+// then releases every waiter in one pass over the ready list.
+
 class Barrier {
   public:
-  	Barrier();
-	~Barrier();
-	void setBarrier(int num);
-	void waitOnBarrier();
+    Barrier(char* debugName, int num);	// initialize a barrier for
+					// "num" threads
+    ~Barrier();				// deallocate the barrier
+    char* getName() { return (name); }
+
+    void setBarrier(int num);		// change the number of threads;
+					// no one may be waiting
+    void setAction(VoidFunctionPtr func, IntPtr arg);
+					// call func(arg) at the end of
+					// every phase
+    bool waitOnBarrier();		// wait for everyone; TRUE in the
+					// last thread to arrive
+    int getPhase() { return phase; }	// # of phases completed
 
   private:
-  	int expectedNum;
-	int arrivedNum;
-	Semaphore *s;
-	Semaphore *mutex;
+    char* name;
+    int expectedNum;			// # of threads that must arrive
+    int arrivedNum;			// # that have, this phase
+    bool sense;				// flipped at the end of each phase
+    int phase;				// # of phases completed
+    List *queue;			// threads waiting, by priority
+    VoidFunctionPtr action;		// called at the end of each phase
+    IntPtr actionArg;
+};
+
+// The following class defines one node of a TreeBarrier.
+
+#define MaxBarrierDepth	32		// levels in a TreeBarrier; plenty,
+					// even with a fanIn of 2
+
+class BarrierNode {
+  public:
+    int expectedNum;			// # of children (threads or nodes)
+    int arrivedNum;			// # that have arrived, this phase
+    BarrierNode *parent;		// NULL for the root
+    List *queue;			// threads that lost here, waiting
 };
 
+// The following class defines a tree-structured ("combining") barrier,
+// for large numbers of threads.  The threads are split into groups of
+// "fanIn", each meeting at a leaf of the tree; the last thread to
+// arrive at a node goes on up to the node's parent, and so on, and the
+// last thread to arrive at the root ends the phase.
+//
+// Only a few threads ever wait at any one node.  Release goes back
+// down the tree: each thread that went on up from a node releases the
+// threads that stopped there, once it is released itself, so the
+// wakeups are spread across the threads instead of all being done by
+// the last one to arrive.
+//
+// Otherwise it works like a Barrier; each thread passes its own
+// number (from 0 to num - 1), which picks its leaf.
+
+class TreeBarrier {
+  public:
+    TreeBarrier(char* debugName, int num, int fanIn);
+					// initialize a barrier for "num"
+					// threads, "fanIn" per node
+    ~TreeBarrier();			// deallocate the barrier
+    char* getName() { return (name); }
+
+    void setAction(VoidFunctionPtr func, IntPtr arg);
+					// call func(arg) at the end of
+					// every phase
+    bool waitOnBarrier(int which);	// wait for everyone; TRUE in the
+					// last thread to arrive
+    int getPhase() { return phase; }	// # of phases completed
+
+  private:
+    char* name;
+    int numThreads;			// # of threads that must arrive
+    int fanIn;				// # of children per node
+    BarrierNode *nodes;			// leaves first, root last
+    int numNodes;
+    int depth;				// # of levels in the tree
+    bool sense;				// flipped at the end of each phase
+    int phase;				// # of phases completed
+    VoidFunctionPtr action;		// called at the end of each phase
+    IntPtr actionArg;
+};
+
+// The following class defines a reader/writer lock.  Any number of
+// readers may hold the lock at once, or a single writer.
+//
+// Readers and writers that can't get in right away wait on a single
+// queue.  When the lock frees up, either the first waiting writer is
+// let in, or every waiting reader is let in together, as one batch,
+// depending on the preference:
+//
+//	PreferWriters -- (the default) no new reader gets in while a
+//		writer is waiting, so writers can't be starved
+//
+//	PreferReaders -- readers get in whenever no writer holds the
+//		lock, so readers can't be starved
+//
+// A reader may upgrade to a writer, waiting for the other readers to
+// leave (only one reader may be upgrading at a time), and a writer
+// may downgrade to a reader, letting in waiting readers with it.
+
+enum RWPreference { PreferWriters, PreferReaders };
+
 class ReadWriteLock {
 	public:
 		ReadWriteLock();
 		~ReadWriteLock();
+		void SetPreference(RWPreference p) { preference = p; }
+
 		void prepareToRead();
 		void finishRead();
 		void prepareToWrite();
 		void finishWrite();
 
+		void upgradeToWrite();	// read lock -> write lock
+		void downgradeToRead();	// write lock -> read lock
+
 	private:
-		Lock *mutex;
-		Lock *w, *r;
-		int rc;
+		List *queue;		// waiting readers and writers
+		int readers;		// # of readers holding the lock
+		Thread *writer;		// writer holding the lock, or NULL
+		Thread *upgrader;	// reader waiting to upgrade, or NULL
+		int waitingWriters;	// # of writers waiting, including
+					// the upgrader
+		RWPreference preference;
+
+		bool ReaderMayEnter();	// can a new reader get in now?
+		void Wakeup();		// let in whoever may enter now
+		int AdmitReaders();	// let in every waiting reader
+		void AdmitWriter();	// let in the first waiting writer
 };
 #endif // SYNCH_H
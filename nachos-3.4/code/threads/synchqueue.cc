@@ -0,0 +1,223 @@
+// synchqueue.cc
+//	Routines for a bounded, synchronized queue.
+//
+//	All operations assume a uniprocessor: each one disables interrupts
+//	for as long as it touches the queue, instead of taking a Lock.
+//	A thread that has to wait goes on a list of waiters and sleeps;
+//	whoever changes the queue wakes as many waiters as it could have
+//	satisfied, and each woken thread re-checks the queue, since
+//	someone else may have got there first.
+//
+// Copyright (c) 1992-1993 The Regents of the University of California.
+// All rights reserved.  See copyright.h for copyright notice and limitation
+// of liability and disclaimer of warranty provisions.
+
+#include "copyright.h"
+#include "synchqueue.h"
+#include "system.h"
+
+//----------------------------------------------------------------------
+// SynchQueue::SynchQueue
+// 	Initialize an empty queue.
+//
+//	"debugName" is an arbitrary name, useful for debugging.
+//	"queueSize" is the most items the queue will hold at once.
+//----------------------------------------------------------------------
+
+SynchQueue::SynchQueue(char* debugName, int queueSize)
+{
+    ASSERT(queueSize > 0);
+    name = debugName;
+    size = queueSize;
+    ring = new void *[size];
+    head = count = 0;
+    getters = new List;
+    putters = new List;
+}
+
+//----------------------------------------------------------------------
+// SynchQueue::~SynchQueue
+// 	De-allocate the queue.  Assume no one is still waiting on it!
+//	Any items still in the queue are not de-allocated.
+//----------------------------------------------------------------------
+
+SynchQueue::~SynchQueue()
+{
+    ASSERT(getters->IsEmpty() && putters->IsEmpty());
+    delete getters;
+    delete putters;
+    delete [] ring;
+}
+
+//----------------------------------------------------------------------
+// SynchQueue::Insert
+// 	Copy as many of "items" onto the back of the queue as will fit,
+//	in at most two pieces (the ring may wrap around).  Return the
+//	number copied.  Called with interrupts disabled.
+//----------------------------------------------------------------------
+
+int
+SynchQueue::Insert(void **items, int n)
+{
+    int num = min(n, size - count);
+    int tail = (head + count) % size;
+    int first = min(num, size - tail);		// up to the end of the ring
+
+    bcopy(items, &ring[tail], first * sizeof(void *));
+    bcopy(items + first, &ring[0], (num - first) * sizeof(void *));
+    count += num;
+    return num;
+}
+
+//----------------------------------------------------------------------
+// SynchQueue::Extract
+// 	Copy up to "n" items off the front of the queue into "items".
+//	Return the number copied.  Called with interrupts disabled.
+//----------------------------------------------------------------------
+
+int
+SynchQueue::Extract(void **items, int n)
+{
+    int num = min(n, count);
+    int first = min(num, size - head);		// up to the end of the ring
+
+    bcopy(&ring[head], items, first * sizeof(void *));
+    bcopy(&ring[0], items + first, (num - first) * sizeof(void *));
+    head = (head + num) % size;
+    count -= num;
+    return num;
+}
+
+//----------------------------------------------------------------------
+// SynchQueue::Wake
+// 	Make up to "n" of the threads waiting on "waiters" ready to run.
+//	Called with interrupts disabled.
+//----------------------------------------------------------------------
+
+void
+SynchQueue::Wake(List *waiters, int n)
+{
+    Thread *thread;
+
+    for (; n > 0; n--) {
+	thread = (Thread *) waiters->Remove();
+	if (thread == NULL)
+	    break;
+	scheduler->ReadyToRun(thread);
+    }
+}
+
+//----------------------------------------------------------------------
+// SynchQueue::PutN
+// 	Put "items[0..n-1]" on the back of the queue, in order.  If they
+//	don't all fit, put what does fit (so that consumers can start on
+//	it), then wait for room for the rest.
+//----------------------------------------------------------------------
+
+void
+SynchQueue::PutN(void **items, int n)
+{
+    IntStatus oldLevel = interrupt->SetLevel(IntOff);
+    int num;
+
+    for (;;) {
+	num = Insert(items, n);
+	Wake(getters, num);
+	items += num;
+	n -= num;
+	if (n == 0)
+	    break;
+	DEBUG('t', "Queue \"%s\" full, %d items still to put\n", name, n);
+	putters->Append((void *)currentThread);
+	currentThread->Sleep();
+    }
+    (void) interrupt->SetLevel(oldLevel);
+}
+
+//----------------------------------------------------------------------
+// SynchQueue::GetN
+// 	Take up to "n" items off the front of the queue, into "items".
+//	Wait only if the queue is empty.  Return the number of items taken.
+//----------------------------------------------------------------------
+
+int
+SynchQueue::GetN(void **items, int n)
+{
+    IntStatus oldLevel = interrupt->SetLevel(IntOff);
+    int num;
+
+    ASSERT(n > 0);
+    while (count == 0) {
+	getters->Append((void *)currentThread);
+	currentThread->Sleep();
+    }
+    num = Extract(items, n);
+    Wake(putters, num);
+    (void) interrupt->SetLevel(oldLevel);
+    return num;
+}
+
+//----------------------------------------------------------------------
+// SynchQueue::Put
+// 	Put one item on the back of the queue, waiting while it is full.
+//----------------------------------------------------------------------
+
+void
+SynchQueue::Put(void *item)
+{
+    PutN(&item, 1);
+}
+
+//----------------------------------------------------------------------
+// SynchQueue::Get
+// 	Take one item off the front of the queue, waiting while it is empty.
+//----------------------------------------------------------------------
+
+void *
+SynchQueue::Get()
+{
+    void *item;
+
+    (void) GetN(&item, 1);
+    return item;
+}
+
+//----------------------------------------------------------------------
+// SynchQueue::TryPut
+// 	Put one item on the back of the queue, if there is room.
+//	Return FALSE, without waiting, if the queue is full.
+//
+//	Safe to call from an interrupt handler.
+//----------------------------------------------------------------------
+
+bool
+SynchQueue::TryPut(void *item)
+{
+    IntStatus oldLevel = interrupt->SetLevel(IntOff);
+    bool done = (Insert(&item, 1) == 1);
+
+    if (done)
+	Wake(getters, 1);
+    (void) interrupt->SetLevel(oldLevel);
+    return done;
+}
+
+//----------------------------------------------------------------------
+// SynchQueue::TryGet
+// 	Take one item off the front of the queue, if there is one.
+//	Return NULL, without waiting, if the queue is empty.
+//
+//	Safe to call from an interrupt handler.
+//----------------------------------------------------------------------
+
+void *
+SynchQueue::TryGet()
+{
+    IntStatus oldLevel = interrupt->SetLevel(IntOff);
+    void *item = NULL;
+
+    if (Extract(&item, 1) == 1)
+	Wake(putters, 1);
+    (void) interrupt->SetLevel(oldLevel);
+    return item;
+}
@@ -0,0 +1,74 @@
+// synchqueue.h
+//	Data structures for a bounded, synchronized queue -- a fixed-size
+//	ring buffer of items, passed from producer threads to consumer
+//	threads.
+//
+//	Unlike a SynchList, a SynchQueue doesn't go through a Lock and
+//	Condition for each item: every operation is a single short
+//	critical section with interrupts disabled, and the batch
+//	operations PutN and GetN move many items in one go.  Threads
+//	wait only when the queue is full (in Put) or empty (in Get).
+//
+//	TryPut and TryGet never wait, so they may be called from an
+//	interrupt handler -- for instance, to hand work from a device
+//	completion straight to a kernel thread.
+//
+// Copyright (c) 1992-1993 The Regents of the University of California.
+// All rights reserved.  See copyright.h for copyright notice and limitation
+// of liability and disclaimer of warranty provisions.
+
+#ifndef SYNCHQUEUE_H
+#define SYNCHQUEUE_H
+
+#include "copyright.h"
+#include "list.h"
+
+// The following class defines a bounded queue, for which:
+//	1. Threads putting an item wait until there is room for it.
+//	2. Threads getting an item wait until there is one to get.
+//	3. Items come out in the order they went in.
+
+class SynchQueue {
+  public:
+    SynchQueue(char* debugName, int size);	// initialize an empty queue
+						// with room for "size" items
+    ~SynchQueue();				// de-allocate the queue
+
+    char* getName() { return name; }	// debugging assist
+
+    void Put(void *item);		// put item at the back, waiting
+					// while the queue is full
+    void *Get();			// get the item at the front,
+					// waiting while the queue is empty
+
+    void PutN(void **items, int n);	// put all of items[0..n-1],
+					// waiting for room as needed
+    int GetN(void **items, int n);	// get up to n items, waiting only
+					// until there is at least one;
+					// returns the number gotten
+
+    bool TryPut(void *item);		// put item if there is room;
+					// never waits
+    void *TryGet();			// get an item, or NULL if the queue
+					// is empty; never waits
+
+    int NumInQueue() { return count; }	// # of items in the queue
+    int Size() { return size; }		// # of items the queue can hold
+
+  private:
+    char* name;				// useful for debugging
+    void **ring;			// the items, in a circular buffer
+    int size;				// # of slots in "ring"
+    int head;				// slot of the item at the front
+    int count;				// # of items in the queue
+    List *getters;			// threads waiting in Get/GetN
+    List *putters;			// threads waiting in Put/PutN
+
+    int Insert(void **items, int n);	// copy in as many of the items as
+					// will fit; return how many did
+    int Extract(void **items, int n);	// copy out up to n items; return
+					// how many there were
+    void Wake(List *waiters, int n);	// wake up to n waiting threads
+};
+
+#endif // SYNCHQUEUE_H
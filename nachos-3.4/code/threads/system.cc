@@ -8,6 +8,7 @@
 #include "copyright.h"
 #include "system.h"
 #include <time.h>
+#include <ctype.h>
 #include "../userprog/bitmap.h"
 
 // This defines *all* of the global data structures used by Nachos.
@@ -20,12 +21,18 @@ Interrupt *interrupt;			// interrupt status
 Statistics *stats;			// performance metricsuserprog/
 Timer *timer;				// the hardware timer device,
 					// for invoking context switches
+ThreadTable *threadTable;		// every thread, indexed by TID
+Alarm *alarmClock;			// wakes up sleeping threads
+SchedTracer *schedTracer;		// traces the scheduler, if asked to
+EventLog *eventLog;			// records or replays interrupts
 #ifdef FILESYS_NEEDED
 FileSystem  *fileSystem;
 #endif
 
 #ifdef FILESYS
-SynchDisk   *synchDisk;
+Volume      *volume;
+BufferCache *bufferCache;
+DiskTracer  *diskTracer;		// traces disk requests, if asked to
 #endif
 
 #ifdef USER_PROGRAM	// requires either FILESYS or FILESYS_STUB
@@ -60,7 +67,7 @@ extern void Cleanup();
 //		whether it needs it or not.
 //----------------------------------------------------------------------
 static void
-TimerInterruptHandler(int dummy)
+TimerInterruptHandler(IntPtr dummy)
 {
     if (interrupt->getStatus() != IdleMode)
 	interrupt->YieldOnReturn();
@@ -82,6 +89,10 @@ Initialize(int argc, char **argv)
     int argCount;
     char* debugArgs = "";
     bool randomYield = FALSE;
+    int alarmSlack = 0;			// how late the alarm may wake threads
+    char* traceFile = NULL;		// where to write a scheduler trace
+    char* logFile = NULL;		// where to record/replay interrupts
+    bool replay = FALSE;
 
 #ifdef USER_PROGRAM
     bool debugUserProg = FALSE;	// single step user program
@@ -89,6 +100,20 @@ Initialize(int argc, char **argv)
 #ifdef FILESYS_NEEDED
     bool format = FALSE;	// format disk
 #endif
+#ifdef FILESYS
+    DiskPolicy diskPolicy = DiskCLOOK;	// order to serve disk requests
+    bool diskMapped = FALSE;		// map the DISK file into memory
+    int diskSyncInterval = 0;		// # of writes between syncs of it
+    DiskGeometry geometry;		// shape of the disk, when formatting
+    VolumeLayout volumeLayout = VolumeStriped;	// how to use several disks
+    int volumeDisks = 1;		// # of disks
+    DeviceKind deviceKind = DeviceDisk;	// and what kind they are
+    bool diskStats = FALSE;		// trace disk requests?
+    char *diskTraceFile = NULL;		// and where to write the trace
+    geometry.sectorSize = SectorSize;
+    geometry.sectorsPerTrack = DefaultSectorsPerTrack;
+    geometry.numTracks = DefaultNumTracks;
+#endif
 #ifdef NETWORK
     double rely = 1;		// network reliability
     int netname = 0;		// UNIX socket name
@@ -109,6 +134,19 @@ Initialize(int argc, char **argv)
 						// number generator
 	    randomYield = TRUE;
 	    argCount = 2;
+	} else if (!strcmp(*argv, "-as")) {
+	    ASSERT(argc > 1);
+	    alarmSlack = atoi(*(argv + 1));	// coalesce alarm wakeups
+	    argCount = 2;
+	} else if (!strcmp(*argv, "-tr")) {
+	    ASSERT(argc > 1);
+	    traceFile = *(argv + 1);		// trace the scheduler
+	    argCount = 2;
+	} else if (!strcmp(*argv, "-rec") || !strcmp(*argv, "-rep")) {
+	    ASSERT(argc > 1);
+	    logFile = *(argv + 1);		// record or replay interrupts
+	    replay = !strcmp(*argv, "-rep");
+	    argCount = 2;
 	}
 #ifdef USER_PROGRAM
 	if (!strcmp(*argv, "-s"))
@@ -118,6 +156,59 @@ Initialize(int argc, char **argv)
 	if (!strcmp(*argv, "-f"))
 	    format = TRUE;
 #endif
+#ifdef FILESYS
+	if (!strcmp(*argv, "-ds")) {
+	    ASSERT(argc > 1);
+	    if (!strcmp(*(argv + 1), "fcfs"))
+		diskPolicy = DiskFCFS;
+	    else if (!strcmp(*(argv + 1), "sstf"))
+		diskPolicy = DiskSSTF;
+	    else if (!strcmp(*(argv + 1), "scan"))
+		diskPolicy = DiskSCAN;
+	    else if (!strcmp(*(argv + 1), "clook"))
+		diskPolicy = DiskCLOOK;
+	    else
+		ASSERT(FALSE);
+	    argCount = 2;
+	} else if (!strcmp(*argv, "-dg")) {
+	    ASSERT(argc > 2);
+	    geometry.sectorsPerTrack = atoi(*(argv + 1));
+	    geometry.numTracks = atoi(*(argv + 2));
+	    argCount = 3;
+	} else if (!strcmp(*argv, "-dv")) {
+	    ASSERT(argc > 2);
+	    if (!strcmp(*(argv + 1), "stripe"))
+		volumeLayout = VolumeStriped;
+	    else if (!strcmp(*(argv + 1), "mirror"))
+		volumeLayout = VolumeMirrored;
+	    else
+		ASSERT(FALSE);
+	    volumeDisks = atoi(*(argv + 2));
+	    argCount = 3;
+	} else if (!strcmp(*argv, "-dk")) {
+	    ASSERT(argc > 1);
+	    if (!strcmp(*(argv + 1), "disk"))
+		deviceKind = DeviceDisk;
+	    else if (!strcmp(*(argv + 1), "flash"))
+		deviceKind = DeviceFlash;
+	    else
+		ASSERT(FALSE);
+	    argCount = 2;
+	} else if (!strcmp(*argv, "-dtrace")) {
+	    ASSERT(argc > 1);
+	    diskStats = TRUE;
+	    diskTraceFile = *(argv + 1);
+	    argCount = 2;
+	} else if (!strcmp(*argv, "-dstat")) {
+	    diskStats = TRUE;
+	} else if (!strcmp(*argv, "-dm")) {
+	    diskMapped = TRUE;
+	    if (argc > 1 && isdigit(**(argv + 1))) {
+		diskSyncInterval = atoi(*(argv + 1));
+		argCount = 2;
+	    }
+	}
+#endif
 #ifdef NETWORK
 	if (!strcmp(*argv, "-l")) {
 	    ASSERT(argc > 1);
@@ -133,12 +224,16 @@ Initialize(int argc, char **argv)
 
     DebugInit(debugArgs);			// initialize DEBUG messages
     stats = new Statistics();			// collect statistics
+    eventLog = (logFile != NULL) ? new EventLog(logFile, replay) : NULL;
     interrupt = new Interrupt;			// start up interrupt handling
     scheduler = new Scheduler();		// initialize the ready queue
+    schedTracer = (traceFile != NULL) ? new SchedTracer(traceFile) : NULL;
     if (randomYield)				// start the timer (if needed)
 	timer = new Timer(TimerInterruptHandler, 0, randomYield);
+    alarmClock = new Alarm(alarmSlack);
 
     threadToBeDestroyed = NULL;
+    threadTable = new ThreadTable(InitialThreadTableSize);
 
     // We didn't explicitly allocate the current thread we are running in.
     // But if it ever tries to give up the CPU, we better have a Thread
@@ -154,7 +249,11 @@ Initialize(int argc, char **argv)
 #endif
 
 #ifdef FILESYS
-    synchDisk = new SynchDisk("DISK");
+    diskTracer = diskStats ? new DiskTracer(diskTraceFile) : NULL;
+    volume = new Volume(volumeLayout, volumeDisks, diskPolicy,
+		format ? &geometry : NULL, diskMapped, diskSyncInterval,
+		deviceKind);
+    bufferCache = new BufferCache(volume, NumCacheBuffers);
 #endif
 
 #ifdef FILESYS_NEEDED
@@ -187,9 +286,13 @@ Cleanup()
 #endif
 
 #ifdef FILESYS
-    delete synchDisk;
+    delete bufferCache;				// write back dirty sectors
+    delete volume;
+    delete diskTracer;				// finish the trace file
 #endif
     
+    delete schedTracer;				// finish the trace file
+    delete eventLog;
     delete timer;
     delete scheduler;
     delete interrupt;
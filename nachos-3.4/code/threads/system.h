@@ -15,6 +15,10 @@
 #include "interrupt.h"
 #include "stats.h"
 #include "timer.h"
+#include "threadtable.h"
+#include "alarm.h"
+#include "schedtrace.h"
+#include "eventlog.h"
 #include "../userprog/bitmap.h"
 
 void GetCurrentDate(char str[],int strlength);
@@ -34,6 +38,12 @@ extern Scheduler *scheduler;			// the ready list
 extern Interrupt *interrupt;			// interrupt status
 extern Statistics *stats;			// performance metrics
 extern Timer *timer;				// the hardware alarm clock
+extern ThreadTable *threadTable;		// every thread, indexed by TID
+extern Alarm *alarmClock;			// wakes up sleeping threads
+extern SchedTracer *schedTracer;		// traces the scheduler; NULL
+						// unless tracing is on
+extern EventLog *eventLog;			// interrupts being recorded or
+						// replayed; NULL if neither
 
 #ifdef USER_PROGRAM
 #include "machine.h"
@@ -46,8 +56,13 @@ extern FileSystem  *fileSystem;
 #endif
 
 #ifdef FILESYS
-#include "synchdisk.h"
-extern SynchDisk   *synchDisk;
+#include "volume.h"
+#include "buffercache.h"
+#include "disktrace.h"
+extern Volume      *volume;
+extern BufferCache *bufferCache;
+extern DiskTracer  *diskTracer;		// traces disk requests; NULL
+					// unless tracing is on
 #endif
 
 #ifdef NETWORK
@@ -35,33 +35,15 @@ extern BitMap *memBitMap;
 //----------------------------------------------------------------------
 
 
-//bool usedTid[MaxThreadNumber] = {false};
-//Thread* threadList[MaxThreadNumber] = {NULL};
-
-typedef struct 
-{
-	Thread *p;
-	bool b = false;
-}aa;
-extern aa *a;
-
 Thread::Thread(char* threadName)
 {
     yonghuID = 0; 
-    priority = 8;
-    int i;
-    for(i = 0; i < 128; i ++)
-    {
-	if(a[i].b == false)
-	{
-		a[i].b = true;
-		a[i].p = this;
-		this->xianchengID = i;
-		break;
-	}
-    }
-    //xianchengID = xianchengnum;
-    //xianchengnum ++;
+    priority = basePriority = 8;
+    waitingOn = NULL;
+    trace = NULL;
+    heldLocks = NULL;
+    exitStatus = 0;
+    xianchengID = threadTable->Allocate(this);
     name = threadName;
     stackTop = NULL;
     stack = NULL;
@@ -87,16 +69,62 @@ Thread::~Thread()
 {
     DEBUG('t', "Deleting thread \"%s\"\n", name);
 
-    int i = this->xianchengID;
-    a[i].b = false;
     ASSERT(this != currentThread);
+    threadTable->Free(xianchengID);
+#ifdef USER_PROGRAM
+    scheduler->ForgetUserState(this);
+#endif
     if (stack != NULL)
-	DeallocBoundedArray((char *) stack, StackSize * sizeof(int));
+	DeallocBoundedArray((char *) stack, StackSize * sizeof(IntPtr));
 }
 
+//----------------------------------------------------------------------
+// Thread::SetPriority
+// 	Set the base priority of the thread; lower values run first.
+//	The effective priority may still be higher, if the thread holds
+//	a lock some more urgent thread is waiting for.
+//----------------------------------------------------------------------
+
 void Thread::SetPriority(int p)
 {
-	priority = p;
+	IntStatus oldLevel = interrupt->SetLevel(IntOff);
+
+	basePriority = p;
+	UpdatePriority();
+	(void) interrupt->SetLevel(oldLevel);
+}
+
+//----------------------------------------------------------------------
+// Thread::UpdatePriority
+// 	Recompute our effective priority: our base priority, raised to
+//	that of the most urgent thread waiting for any lock we hold.
+//
+//	If it changed, fix up our place on whatever queue we are on.
+//	If we are ourselves waiting for a lock, the holder of that
+//	lock may need its priority changed too, and so on down the
+//	chain -- this is what makes priority inheritance transitive.
+//
+//	Must be called with interrupts disabled.
+//----------------------------------------------------------------------
+
+void
+Thread::UpdatePriority()
+{
+    int p = basePriority;
+
+    ASSERT(interrupt->getLevel() == IntOff);
+    for (Lock *l = heldLocks; l != NULL; l = l->nextHeld)
+	p = min(p, l->WaiterPriority());
+    if (p == priority)
+	return;
+
+    DEBUG('t', "Priority of \"%s\" changes from %d to %d\n",
+					name, priority, p);
+    priority = p;
+    if (status == READY)
+	scheduler->Reprioritize(this);
+    if (waitingOn != NULL)
+	waitingOn->Reprioritize(this);
 }
 //----------------------------------------------------------------------
 // Thread::Fork
@@ -119,10 +147,10 @@ void Thread::SetPriority(int p)
 //----------------------------------------------------------------------
 
 void 
-Thread::Fork(VoidFunctionPtr func, int arg)
+Thread::Fork(VoidFunctionPtr func, IntPtr arg)
 {
-    DEBUG('t', "Forking thread \"%s\" with func = 0x%x, arg = %d\n",
-	  name, (int) func, arg);
+    DEBUG('t', "Forking thread \"%s\" with func = %p, arg = %ld\n",
+	  name, (void *) func, arg);
     
     StackAllocate(func, arg);
 
@@ -183,6 +211,7 @@ Thread::Finish ()
     
     DEBUG('t', "Finishing thread \"%s\"\n", getName());
     
+    threadTable->Finished(xianchengID, exitStatus);	// wake up Join
     threadToBeDestroyed = currentThread;
     Sleep();					// invokes SWITCH
     // not reached
@@ -253,6 +282,8 @@ Thread::Sleep ()
     
     DEBUG('t', "Sleeping thread \"%s\"\n", getName());
 
+    if (schedTracer != NULL)
+	schedTracer->Block(this, NULL);
     status = BLOCKED;
     while ((nextThread = scheduler->FindNextToRun()) == NULL)
 	interrupt->Idle();	// no one to run, wait for an interrupt
@@ -260,6 +291,23 @@ Thread::Sleep ()
     scheduler->Run(nextThread); // returns when we've been signalled
 }
 
+//----------------------------------------------------------------------
+// Thread::SleepFor
+// 	Relinquish the CPU for "ticks" of simulated time.  Unlike calling
+//	Yield in a loop, the thread is off the ready list the whole time,
+//	so if nothing else is runnable, the clock fast-forwards to when
+//	the thread is due.
+//
+//	"ticks" is how long to sleep
+//----------------------------------------------------------------------
+
+void
+Thread::SleepFor(int ticks)
+{
+    ASSERT(this == currentThread);
+    alarmClock->SleepFor(ticks);
+}
+
 //----------------------------------------------------------------------
 // ThreadFinish, InterruptEnable, ThreadPrint
 //	Dummy functions because C++ does not allow a pointer to a member
@@ -270,7 +318,7 @@ Thread::Sleep ()
 
 static void ThreadFinish()    { currentThread->Finish(); }
 static void InterruptEnable() { interrupt->Enable(); }
-void ThreadPrint(int arg){ Thread *t = (Thread *)arg; t->Print(); }
+void ThreadPrint(IntPtr arg){ Thread *t = (Thread *)arg; t->Print(); }
 
 //----------------------------------------------------------------------
 // Thread::StackAllocate
@@ -285,9 +333,9 @@ void ThreadPrint(int arg){ Thread *t = (Thread *)arg; t->Print(); }
 //----------------------------------------------------------------------
 
 void
-Thread::StackAllocate (VoidFunctionPtr func, int arg)
+Thread::StackAllocate (VoidFunctionPtr func, IntPtr arg)
 {
-    stack = (int *) AllocBoundedArray(StackSize * sizeof(int));
+    stack = (IntPtr *) AllocBoundedArray(StackSize * sizeof(IntPtr));
 
 #ifdef HOST_SNAKE
     // HP stack works from low addresses to high addresses
@@ -298,24 +346,24 @@ Thread::StackAllocate (VoidFunctionPtr func, int arg)
 #ifdef HOST_SPARC
     // SPARC stack must contains at least 1 activation record to start with.
     stackTop = stack + StackSize - 96;
-#else  // HOST_MIPS  || HOST_i386
+#else  // HOST_MIPS  || HOST_i386 || HOST_x86_64
     stackTop = stack + StackSize - 4;	// -4 to be on the safe side!
-#ifdef HOST_i386
+#if defined(HOST_i386) || defined(HOST_x86_64)
     // the 80386 passes the return address on the stack.  In order for
     // SWITCH() to go to ThreadRoot when we switch to this thread, the
     // return addres used in SWITCH() must be the starting address of
     // ThreadRoot.
-    *(--stackTop) = (int)ThreadRoot;
+    *(--stackTop) = (IntPtr) ThreadRoot;
 #endif
 #endif  // HOST_SPARC
     *stack = STACK_FENCEPOST;
 #endif  // HOST_SNAKE
     
-    machineState[PCState] = (int) ThreadRoot;
-    machineState[StartupPCState] = (int) InterruptEnable;
-    machineState[InitialPCState] = (int) func;
+    machineState[PCState] = (IntPtr) ThreadRoot;
+    machineState[StartupPCState] = (IntPtr) InterruptEnable;
+    machineState[InitialPCState] = (IntPtr) func;
     machineState[InitialArgState] = arg;
-    machineState[WhenDonePCState] = (int) ThreadFinish;
+    machineState[WhenDonePCState] = (IntPtr) ThreadFinish;
 }
 
 #ifdef USER_PROGRAM
@@ -328,6 +376,7 @@ Thread::suspend(Thread* t)
 	//still need to check if tlb is dirty, if it is, write to pagetable, then decide whether write a page back to memory
 	IntStatus oldLevel = interrupt->SetLevel(IntOff);
 	
+	scheduler->UnloadAddrSpace(t->space);	// TLB may map pages we free
 	for(int i = 0; i < t->space->numPages; i++) {
 		if(t->space->pageTable[i].valid == TRUE) {
 			int vpn = t->space->pageTable[i].virtualPage;
@@ -348,7 +397,8 @@ Thread::suspend(Thread* t)
 
 //----------------------------------------------------------------------
 // Thread::SaveUserState
-//	Save the CPU state of a user program on a context switch.
+//	Save the CPU state of a user program, when some other thread's
+//	user program needs the machine (see Scheduler::SwitchUserState).
 //
 //	Note that a user program thread has *two* sets of CPU registers -- 
 //	one for its state while executing user code, one for its state 
@@ -358,13 +408,13 @@ Thread::suspend(Thread* t)
 void
 Thread::SaveUserState()
 {
-    for (int i = 0; i < NumTotalRegs; i++)
-	userRegisters[i] = machine->ReadRegister(i);
+    memcpy(userRegisters, machine->registers, sizeof(userRegisters));
 }
 
 //----------------------------------------------------------------------
 // Thread::RestoreUserState
-//	Restore the CPU state of a user program on a context switch.
+//	Restore the CPU state of a user program, when it gets the machine
+//	back from some other thread's user program.
 //
 //	Note that a user program thread has *two* sets of CPU registers -- 
 //	one for its state while executing user code, one for its state 
@@ -374,7 +424,6 @@ Thread::SaveUserState()
 void
 Thread::RestoreUserState()
 {
-    for (int i = 0; i < NumTotalRegs; i++)
-	machine->WriteRegister(i, userRegisters[i]);
+    memcpy(machine->registers, userRegisters, sizeof(userRegisters));
 }
 #endif
@@ -39,6 +39,7 @@
 
 #include "copyright.h"
 #include "utility.h"
+#include "stats.h"
 
 #ifdef USER_PROGRAM
 #include "machine.h"
@@ -53,14 +54,14 @@
 
 // Size of the thread's private execution stack.
 // WATCH OUT IF THIS ISN'T BIG ENOUGH!!!!!
-#define StackSize	(4 * 1024)	// in words
+#define StackSize	(4 * 1024)	// in words (IntPtr's)
 
 
 // Thread state
 enum ThreadStatus { JUST_CREATED, RUNNING, READY, BLOCKED, SUSPENDED };
 
 // external function, dummy routine whose sole job is to call Thread::Print
-extern void ThreadPrint(int arg);	 
+extern void ThreadPrint(IntPtr arg);	 
 
 // The following class defines a "thread control block" -- which
 // represents a single thread of execution.
@@ -73,19 +74,32 @@ extern void ThreadPrint(int arg);
 //  Some threads also belong to a user address space; threads
 //  that only run in the kernel have a NULL address space.
 extern int xianchengnum;
+class Lock;
+class ThreadTrace;
+
 class Thread {
   private:
     // NOTE: DO NOT CHANGE the order of these first two members.
     // THEY MUST be in this position for SWITCH to work.
-    int* stackTop;			 // the current stack pointer
-    int machineState[MachineStateSize];  // all registers except for stackTop
+    IntPtr* stackTop;			 // the current stack pointer
+    IntPtr machineState[MachineStateSize];  // all registers except for
+					 // stackTop; each one pointer-sized
    
 
   public:
 
     int xianchengID;
-    int priority;
+    int priority;			// effective priority -- lower runs
+					// first; may be raised above
+					// basePriority by lock waiters
+    int basePriority;			// priority set by SetPriority
+    Lock *waitingOn;			// lock we are blocked in Acquire on
+    Lock *heldLocks;			// locks we hold, chained by nextHeld
+    ThreadTrace *trace;			// what the scheduler tracer knows
+					// about us; NULL if not traced
     int yonghuID;
+    int exitStatus;			// handed to Join when we finish
+    UsageStats usage;			// resources we have used
     Thread(char* debugName);		// initialize a Thread 
     ~Thread(); 				// deallocate a Thread
 					// NOTE -- thread being deleted
@@ -94,15 +108,19 @@ class Thread {
 
     // basic thread operations
 
-    void Fork(VoidFunctionPtr func, int arg); 	// Make thread run (*func)(arg)
+    void Fork(VoidFunctionPtr func, IntPtr arg); 	// Make thread run (*func)(arg)
 	
     void SetPriority(int p);
+    void UpdatePriority();		// recompute priority, after a change
+					// to basePriority or held locks
 
     void Yield();  				// Relinquish the CPU if any 
 						// other thread is runnable
     void Sleep();  				// Put the thread to sleep and 
 						// relinquish the processor
     void Finish();  				// The thread is done executing
+    void SleepFor(int ticks);			// Put the thread to sleep for
+						// "ticks" of simulated time
     
     void CheckOverflow();   			// Check if thread has 
 						// overflowed its stack
@@ -115,13 +133,13 @@ class Thread {
   private:
     // some of the private data for this class is listed above
     
-    int* stack; 	 		// Bottom of the stack 
+    IntPtr* stack; 	 		// Bottom of the stack 
 					// NULL if this is the main thread
 					// (If NULL, don't deallocate stack)
     ThreadStatus status;		// ready, running or blocked
     char* name;
 
-    void StackAllocate(VoidFunctionPtr func, int arg);
+    void StackAllocate(VoidFunctionPtr func, IntPtr arg);
     					// Allocate a stack for thread.
 					// Used internally by Fork()
 
@@ -0,0 +1,296 @@
+// threadtable.cc
+//	Routines to manage the table of threads, indexed by thread ID.
+//
+//	Free slots are kept on a FIFO free list -- a slot that has just
+//	been freed goes to the back of the line, so that it is the
+//	last to be handed out again.  Together with the per-slot
+//	generation count, this keeps stale TIDs from being confused
+//	with live ones for as long as possible.
+//
+//	Join is built on a per-slot semaphore that starts at 0 and is
+//	V'ed once, when the thread finishes.  Each joiner does a P
+//	followed by a V, so that the single V lets every joiner through,
+//	no matter how many there are or when they arrive.
+//
+// Copyright (c) 1992-1993 The Regents of the University of California.
+// All rights reserved.  See copyright.h for copyright notice and limitation
+// of liability and disclaimer of warranty provisions.
+
+#include "copyright.h"
+#include "threadtable.h"
+#include "system.h"
+
+//----------------------------------------------------------------------
+// ThreadTable::ThreadTable
+// 	Initialize an empty thread table, with every slot on the free list.
+//
+//	"initialSize" is the number of slots to start with; the table
+//		grows on demand.
+//----------------------------------------------------------------------
+
+ThreadTable::ThreadTable(int initialSize)
+{
+    ASSERT(initialSize > 0 && initialSize <= MaxThreads);
+    numInUse = 0;
+    freeHead = freeTail = -1;
+
+    table = new ThreadTableEntry[initialSize];
+    tableSize = initialSize;
+    for (int i = 0; i < tableSize; i++) {
+	InitEntry(i);
+	AppendFree(i);
+    }
+}
+
+//----------------------------------------------------------------------
+// ThreadTable::~ThreadTable
+// 	De-allocate the thread table.  Note that we do *not* delete
+//	the threads themselves.
+//----------------------------------------------------------------------
+
+ThreadTable::~ThreadTable()
+{
+    for (int i = 0; i < tableSize; i++)
+	delete table[i].done;
+    delete [] table;
+}
+
+//----------------------------------------------------------------------
+// ThreadTable::InitEntry
+// 	Set up a slot that has never been handed out.  The generation
+//	starts one short of wrapping around, so the first TID from the
+//	slot has generation 0 -- in particular, the main thread is TID 0.
+//----------------------------------------------------------------------
+
+void
+ThreadTable::InitEntry(int slot)
+{
+    table[slot].thread = NULL;
+    table[slot].generation = MaxGeneration;
+    table[slot].finished = FALSE;
+    table[slot].exitStatus = 0;
+    table[slot].done = new Semaphore("join", 0);
+    table[slot].numJoiners = 0;
+}
+
+//----------------------------------------------------------------------
+// ThreadTable::AppendFree
+// 	Put a slot on the end of the free list.
+//----------------------------------------------------------------------
+
+void
+ThreadTable::AppendFree(int slot)
+{
+    table[slot].nextFree = -1;
+    if (freeTail == -1)
+	freeHead = slot;
+    else
+	table[freeTail].nextFree = slot;
+    freeTail = slot;
+}
+
+//----------------------------------------------------------------------
+// ThreadTable::Grow
+// 	Double the number of slots in the table, putting the new slots
+//	on the free list.  The free list must be empty when this is called.
+//----------------------------------------------------------------------
+
+void
+ThreadTable::Grow()
+{
+    int oldSize = tableSize;
+    int newSize = min(tableSize * 2, MaxThreads);
+    ThreadTableEntry *newTable;
+
+    ASSERT(freeHead == -1);
+    if (newSize == oldSize)
+	return;				// can't grow any more
+
+    DEBUG('t', "Growing thread table from %d to %d slots\n",
+					oldSize, newSize);
+    newTable = new ThreadTableEntry[newSize];
+    for (int i = 0; i < oldSize; i++)
+	newTable[i] = table[i];
+    delete [] table;
+    table = newTable;
+
+    tableSize = newSize;
+    for (int i = oldSize; i < newSize; i++) {
+	InitEntry(i);
+	AppendFree(i);
+    }
+}
+
+//----------------------------------------------------------------------
+// ThreadTable::Allocate
+// 	Take a slot off the free list for "thread", growing the table
+//	if there are no free slots.  The slot's generation is bumped,
+//	so that any TID it was handed out under before is now stale.
+//	Return the new TID.
+//
+//	"thread" is the newly created thread
+//----------------------------------------------------------------------
+
+int
+ThreadTable::Allocate(Thread *thread)
+{
+    IntStatus oldLevel = interrupt->SetLevel(IntOff);
+    ThreadTableEntry *entry;
+    int slot;
+
+    if (freeHead == -1)
+	Grow();
+    slot = freeHead;
+    ASSERT(slot != -1);			// more than MaxThreads threads!
+
+    freeHead = table[slot].nextFree;
+    if (freeHead == -1)
+	freeTail = -1;
+    entry = &table[slot];
+    ASSERT(entry->numJoiners == 0);
+    entry->thread = thread;
+    entry->generation = (entry->generation + 1) & MaxGeneration;
+    entry->finished = FALSE;
+    entry->exitStatus = 0;
+    delete entry->done;			// last user may have left it at 1
+    entry->done = new Semaphore("join", 0);
+    numInUse++;
+
+    (void) interrupt->SetLevel(oldLevel);
+    return (entry->generation << TidSlotBits) | slot;
+}
+
+//----------------------------------------------------------------------
+// ThreadTable::Free
+// 	Give back the slot for a thread that is being destroyed.  The
+//	slot keeps the thread's exit status until it is handed out
+//	again; if some thread is still on its way out of Join, the
+//	slot isn't put on the free list until the last one leaves.
+//
+//	"tid" is the TID of the thread being destroyed
+//----------------------------------------------------------------------
+
+void
+ThreadTable::Free(int tid)
+{
+    IntStatus oldLevel = interrupt->SetLevel(IntOff);
+    ThreadTableEntry *entry = FindEntry(tid);
+    int slot = TidToSlot(tid);
+
+    ASSERT(entry != NULL && entry->thread != NULL);
+    entry->thread = NULL;
+    numInUse--;
+    if (entry->numJoiners == 0)
+	AppendFree(slot);
+    (void) interrupt->SetLevel(oldLevel);
+}
+
+//----------------------------------------------------------------------
+// ThreadTable::FindEntry
+// 	Return the slot for "tid", or NULL if "tid" doesn't name a
+//	thread (it is out of range, never handed out, or from an older
+//	generation).  The thread may have already been destroyed, if
+//	the slot hasn't been reused yet.
+//----------------------------------------------------------------------
+
+ThreadTableEntry *
+ThreadTable::FindEntry(int tid)
+{
+    int slot = TidToSlot(tid);
+
+    if (tid < 0 || slot >= tableSize)
+	return NULL;
+    if (table[slot].generation != TidToGeneration(tid))
+	return NULL;
+    if (table[slot].thread == NULL && !table[slot].finished)
+	return NULL;			// never handed out
+    return &table[slot];
+}
+
+//----------------------------------------------------------------------
+// ThreadTable::Lookup
+// 	Return the thread with TID "tid", or NULL if there isn't one.
+//----------------------------------------------------------------------
+
+Thread *
+ThreadTable::Lookup(int tid)
+{
+    ThreadTableEntry *entry = FindEntry(tid);
+
+    return (entry == NULL) ? NULL : entry->thread;
+}
+
+//----------------------------------------------------------------------
+// ThreadTable::Join
+// 	Wait until thread "tid" has finished, and return its exit status.
+//	Returns immediately if it has already finished; returns -1 if
+//	there is no such thread.  A thread may not join itself; SC_Join
+//	checks for that, since a user program could ask.
+//
+//	"tid" is the thread to wait for
+//----------------------------------------------------------------------
+
+int
+ThreadTable::Join(int tid)
+{
+    IntStatus oldLevel = interrupt->SetLevel(IntOff);
+    ThreadTableEntry *entry = FindEntry(tid);
+    int slot = TidToSlot(tid);
+    int status = -1;
+
+    if (entry != NULL && !entry->finished) {
+	Semaphore *done = entry->done;
+
+	ASSERT(entry->thread != currentThread);	// would wait forever
+	DEBUG('t', "Thread \"%s\" joining thread \"%s\"\n",
+			currentThread->getName(), entry->thread->getName());
+	entry->numJoiners++;
+	done->P();
+	done->V();			// let the next joiner through
+
+	entry = &table[slot];		// table may have grown while we slept
+	entry->numJoiners--;
+	if (entry->numJoiners == 0 && entry->thread == NULL)
+	    AppendFree(slot);		// Free left the slot to us
+    }
+    if (entry != NULL)
+	status = entry->exitStatus;
+    (void) interrupt->SetLevel(oldLevel);
+    return status;
+}
+
+//----------------------------------------------------------------------
+// ThreadTable::Finished
+// 	Thread "tid" is about to finish with "status"; let every thread
+//	waiting for it in Join proceed.
+//
+//	Called by Thread::Finish, with interrupts disabled.
+//----------------------------------------------------------------------
+
+void
+ThreadTable::Finished(int tid, int status)
+{
+    ThreadTableEntry *entry = FindEntry(tid);
+
+    ASSERT(interrupt->getLevel() == IntOff);
+    if (entry == NULL)
+	return;
+    entry->finished = TRUE;
+    entry->exitStatus = status;
+    entry->done->V();
+}
+
+//----------------------------------------------------------------------
+// ThreadTable::Print
+// 	Print the TID and name of every live thread.  For debugging.
+//----------------------------------------------------------------------
+
+void
+ThreadTable::Print()
+{
+    printf("Thread table: %d of %d slots in use\n", numInUse, tableSize);
+    for (int i = 0; i < tableSize; i++)
+	if (table[i].thread != NULL)
+	    printf("%d: %s\n", (table[i].generation << TidSlotBits) | i,
+					table[i].thread->getName());
+}
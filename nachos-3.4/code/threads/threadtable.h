@@ -0,0 +1,95 @@
+// threadtable.h
+//	Data structures for keeping track of every thread in the system,
+//	indexed by thread ID (TID).
+//
+//	Each thread is given a slot in a table when it is created, and
+//	gives the slot back when it is destroyed.  Free slots are kept
+//	on a free list, so that allocating and freeing a TID is O(1);
+//	if the free list runs dry, the table is doubled in size.
+//
+//	A TID encodes both the slot number and a "generation" count for
+//	the slot.  The generation is bumped every time a slot is recycled,
+//	so a stale TID (one whose thread has already gone away) can never
+//	be mistaken for the newer thread that happens to reuse the slot.
+//
+//	Each slot also has a semaphore that threads in Join wait on until
+//	the slot's thread finishes, and the exit status it finished with.
+//	The status stays in the slot after the thread is destroyed, until
+//	the slot is handed out again, so a late Join still gets it.
+//
+// Copyright (c) 1992-1993 The Regents of the University of California.
+// All rights reserved.  See copyright.h for copyright notice and limitation
+// of liability and disclaimer of warranty provisions.
+
+#ifndef THREADTABLE_H
+#define THREADTABLE_H
+
+#include "copyright.h"
+#include "synch.h"
+
+#define TidSlotBits		16	// low bits of a TID are the slot #
+#define MaxThreads		(1 << TidSlotBits)
+#define MaxGeneration		0x7fff	// keeps every TID positive
+#define InitialThreadTableSize	16
+
+#define TidToSlot(tid)		((tid) & (MaxThreads - 1))
+#define TidToGeneration(tid)	((tid) >> TidSlotBits)
+
+// The following class defines one slot in the thread table.
+//
+// Internal data structures kept public so that ThreadTable operations
+// can access them directly.
+
+class ThreadTableEntry {
+  public:
+    Thread *thread;		// the thread in this slot, NULL if free
+    int generation;		// # of times this slot has been handed out
+    int nextFree;		// next slot on the free list, -1 if none
+    bool finished;		// has the thread called Thread::Finish?
+    int exitStatus;		// valid once "finished" is set
+    Semaphore *done;		// V'ed once, when the thread finishes
+    int numJoiners;		// # of threads still inside Join; the
+				// slot can't be recycled until it is 0
+};
+
+// The following class defines the thread table -- the mapping from
+// TID to thread, plus the free list used to hand out TIDs.
+//
+// All operations assume a uniprocessor; they disable interrupts
+// internally where they need to be atomic.
+
+class ThreadTable {
+  public:
+    ThreadTable(int initialSize);	// Initialize an empty table
+    ~ThreadTable();			// De-allocate the table
+
+    int Allocate(Thread *thread);	// Give "thread" a TID
+    void Free(int tid);			// Give the TID back, when the
+					// thread is destroyed
+
+    Thread *Lookup(int tid);		// Return the thread for "tid",
+					// NULL if "tid" is free or stale
+
+    int Join(int tid);			// Wait until thread "tid" finishes,
+					// and return its exit status
+    void Finished(int tid, int status);	// Called by Thread::Finish, to
+					// wake up any threads in Join
+
+    int NumInUse() { return numInUse; }	// # of live threads
+    void Print();			// Print the names of live threads
+
+  private:
+    ThreadTableEntry *table;		// one entry per slot
+    int tableSize;			// # of slots in "table"
+    int numInUse;			// # of slots holding a thread
+    int freeHead;			// first free slot, -1 if none
+    int freeTail;			// last free slot, -1 if none
+
+    ThreadTableEntry *FindEntry(int tid);	// NULL if "tid" is stale
+    void InitEntry(int slot);		// set up a never-used slot
+    void AppendFree(int slot);		// put "slot" at the end of
+					// the free list
+    void Grow();			// double the size of the table
+};
+
+#endif // THREADTABLE_H
@@ -13,16 +13,12 @@
 #include "system.h"
 #include "thread.h"
 #include "synch.h"
+#include "synchqueue.h"
+#include "workpool.h"
 
 // testnum is set in main.cc
 int testnum = 1;
 int xianchengnum = 0;
-struct aa
-{
-	Thread *p;
-	bool b = false;
-};
-aa *a = new aa[128];
 
 //----------------------------------------------------------------------
 // SimpleThread
@@ -34,12 +30,12 @@ aa *a = new aa[128];
 //----------------------------------------------------------------------
 
 void
-SimpleThread(int which)
+SimpleThread(IntPtr which)
 {
     int num;
     
     for (num = 0; num < 5; num++) {
-	printf("*** thread %d looped %d times\n", which, num);
+	printf("*** thread %d looped %d times\n", (int) which, num);
 	printf("%d\n", currentThread->xianchengID);
         currentThread->Yield();
     }
@@ -86,13 +82,13 @@ void ThreadTest2()
 extern void StartProcess(char *file);
 #ifdef USER_PROGRAM
 
-void usertest1(int which)
+void usertest1(IntPtr which)
 {
         char *testname = "../test/tt1";
         StartProcess(testname);
 }
 
-void usertest2(int which)
+void usertest2(IntPtr which)
 {
         char *testname = "../test/tt2";
         StartProcess(testname);
@@ -112,6 +108,16 @@ void DoubleThreadTest()
 }
 
 #endif // USER_PROGRAM
+
+void myTest_ThreadTable();
+void myTest_PriorityInheritance();
+void myTest_ProducerConsumer();
+void myTest_RWLock();
+void myTest_Alarm();
+void myTest_SynchQueue();
+void myTest_Barrier();
+void myTest_WorkPool();
+
 void
 ThreadTest()
 {
@@ -125,6 +131,30 @@ ThreadTest()
 	ThreadTest2();
         #endif
 	break;
+    case 2:
+	myTest_ThreadTable();
+	break;
+    case 3:
+	myTest_PriorityInheritance();
+	break;
+    case 4:
+	myTest_ProducerConsumer();
+	break;
+    case 5:
+	myTest_RWLock();
+	break;
+    case 6:
+	myTest_Alarm();
+	break;
+    case 7:
+	myTest_SynchQueue();
+	break;
+    case 8:
+	myTest_Barrier();
+	break;
+    case 9:
+	myTest_WorkPool();
+	break;
     default:
 	printf("No test specified.\n");
 	break;
@@ -140,16 +170,16 @@ Lock *conditionLock = new Lock("condition lock");
 Condition *empty = new Condition("empty condition");
 Condition *full = new Condition("full condition");
 
-void Producer(int which)
+void Producer(IntPtr which)
 {
 	for(int i = 0; i < 20; i++)
 	{
 		conditionLock->Acquire();
-		if(count == 10)
+		while(count == 10)		// Mesa semantics: re-check
 			full->Wait(conditionLock);
 		buffer[(currentProduce++)%10] = 1;
 		count++;
-		printf("Thread %d produces at place %d.\n", which, (currentProduce-1)%10);
+		printf("Thread %d produces at place %d.\n", (int) which, (currentProduce-1)%10);
 		empty->Signal(conditionLock);
 		conditionLock->Release();
 		if(count == 4)
@@ -157,16 +187,16 @@ void Producer(int which)
 	}
 }
 
-void Consumer(int which)
+void Consumer(IntPtr which)
 {
 	for(int i = 0; i < 20; i++)
 	{
 		conditionLock->Acquire();
-		if(count == 0)
+		while(count == 0)
 			empty->Wait(conditionLock);
 		buffer[(currentConsume++)%10] = 0;
 		count--;
-		printf("Thread %d consumes at place %d.\n", which, (currentConsume-1)%10);
+		printf("Thread %d consumes at place %d.\n", (int) which, (currentConsume-1)%10);
 		full->Signal(conditionLock);
 		conditionLock->Release();
 	}
@@ -189,7 +219,7 @@ Semaphore *mutex = new Semaphore("mutex", 1);
 Semaphore *w = new Semaphore("w", 1);
 int rc = 0;
 
-void reader(int which)
+void reader(IntPtr which)
 {
 	for(int i = 0; i < 3; i++) {
 		mutex->P();
@@ -198,9 +228,9 @@ void reader(int which)
 			w->P();
 		mutex->V();
 
-		printf("Thread %d is reading\n", which);
+		printf("Thread %d is reading\n", (int) which);
 		currentThread->Yield();
-		printf("Thread %d finishes reading\n", which);
+		printf("Thread %d finishes reading\n", (int) which);
 		currentThread->Yield();
 
 		mutex->P();
@@ -211,14 +241,14 @@ void reader(int which)
 	}
 }
 
-void writer(int which)
+void writer(IntPtr which)
 {
 	for(int i = 0; i < 3; i++) {
 		w->P();
 
-		printf("Thread %d is writing\n", which);
+		printf("Thread %d is writing\n", (int) which);
 		currentThread->Yield();
-		printf("Thread %d finishes writing\n", which);
+		printf("Thread %d finishes writing\n", (int) which);
 
 		w->V();
 		currentThread->Yield();
@@ -238,3 +268,421 @@ myTest_ReaderWriter()
 	currentThread->Yield();
 }
 
+//----------------------------------------------------------------------
+// myTest_ThreadTable
+// 	Fork more threads than the thread table starts out with, then
+//	Join each of them.  Join should block until the thread has
+//	finished and return its exit status, and a stale TID should
+//	not be found again.
+//
+//	Fork runs the new thread right away, so each joinee waits on
+//	"joineeStart" until they have all been forked.
+//----------------------------------------------------------------------
+
+Semaphore *joineeStart;
+
+void
+Joinee(IntPtr which)
+{
+	joineeStart->P();
+	currentThread->exitStatus = (int) which;
+}
+
+void
+myTest_ThreadTable()
+{
+	int n = 4 * InitialThreadTableSize;
+	int *tids = new int[n];
+	int i;
+
+	joineeStart = new Semaphore("joinee start", 0);
+	for (i = 0; i < n; i++) {
+		Thread *t = new Thread("joinee");
+		tids[i] = t->getTID();
+		t->Fork(Joinee, i);
+	}
+	for (i = 0; i < n; i++)
+		joineeStart->V();
+	for (i = 0; i < n; i++) {
+		int status = threadTable->Join(tids[i]);
+		ASSERT(status == i);
+	}
+
+	currentThread->Yield();		// let the last thread be destroyed
+	for (i = 0; i < n; i++)
+		ASSERT(threadTable->Lookup(tids[i]) == NULL);
+	printf("Joined %d threads, %d still in use\n", n,
+					threadTable->NumInUse());
+	delete [] tids;
+	delete joineeStart;
+}
+
+//----------------------------------------------------------------------
+// myTest_PriorityInheritance
+// 	A low priority thread holds a lock that a high priority thread
+//	wants, while a medium priority thread is ready to run.  The
+//	low priority thread should inherit the high priority, so that
+//	it runs (and releases the lock) ahead of the medium one.
+//----------------------------------------------------------------------
+
+Lock *inversionLock;
+
+void
+LowHolder(IntPtr which)
+{
+	inversionLock->Acquire();
+	currentThread->Yield();		// high blocks on the lock meanwhile
+	printf("low holder running at priority %d\n", currentThread->priority);
+	ASSERT(currentThread->priority == 1);
+	inversionLock->Release();
+	ASSERT(currentThread->priority == 9);
+	printf("low holder back at priority %d\n", currentThread->priority);
+}
+
+void
+MediumSpinner(IntPtr which)
+{
+	for (int num = 0; num < 3; num++) {
+		printf("medium thread looped %d times\n", num);
+		currentThread->Yield();
+	}
+}
+
+void
+HighWaiter(IntPtr which)
+{
+	inversionLock->Acquire();
+	printf("high waiter got the lock\n");
+	inversionLock->Release();
+}
+
+void
+myTest_PriorityInheritance()
+{
+	Thread *low = new Thread("low");
+	Thread *medium = new Thread("medium");
+	Thread *high = new Thread("high");
+
+	inversionLock = new Lock("inversion lock");
+	inversionLock->EnableStats();
+
+	low->SetPriority(9);
+	low->Fork(LowHolder, 0);		// Fork lets low get the lock
+
+	medium->SetPriority(5);
+	medium->Fork(MediumSpinner, 0);
+	high->SetPriority(1);
+	high->Fork(HighWaiter, 0);
+
+	threadTable->Join(low->getTID());
+	inversionLock->PrintStats();
+}
+
+//----------------------------------------------------------------------
+// myTest_RWLock
+// 	Readers and writers share a ReadWriteLock; one reader upgrades
+//	to a writer and back.  Check that no one reads while someone
+//	writes, and that at most one thread writes at a time.
+//----------------------------------------------------------------------
+
+ReadWriteLock *rwLock;
+int activeReaders = 0;
+int activeWriters = 0;
+
+void
+RWReader(IntPtr which)
+{
+	for (int i = 0; i < 3; i++) {
+		rwLock->prepareToRead();
+		activeReaders++;
+		ASSERT(activeWriters == 0);
+		printf("Thread %d reads with %d readers\n", (int) which, activeReaders);
+		currentThread->Yield();
+		if (which == 1 && i == 1) {	// upgrade, then downgrade
+			activeReaders--;
+			rwLock->upgradeToWrite();
+			activeWriters++;
+			ASSERT(activeReaders == 0 && activeWriters == 1);
+			printf("Thread %d upgraded to writer\n", (int) which);
+			currentThread->Yield();
+			activeWriters--;
+			rwLock->downgradeToRead();
+			activeReaders++;
+		}
+		activeReaders--;
+		rwLock->finishRead();
+		currentThread->Yield();
+	}
+}
+
+void
+RWWriter(IntPtr which)
+{
+	for (int i = 0; i < 3; i++) {
+		rwLock->prepareToWrite();
+		activeWriters++;
+		ASSERT(activeReaders == 0 && activeWriters == 1);
+		printf("Thread %d writes\n", (int) which);
+		currentThread->Yield();
+		activeWriters--;
+		rwLock->finishWrite();
+		currentThread->Yield();
+	}
+}
+
+void
+myTest_RWLock()
+{
+	rwLock = new ReadWriteLock();
+
+	(new Thread("RWReader1"))->Fork(RWReader, 1);
+	(new Thread("RWReader2"))->Fork(RWReader, 2);
+	(new Thread("RWWriter3"))->Fork(RWWriter, 3);
+	(new Thread("RWReader4"))->Fork(RWReader, 4);
+	(new Thread("RWWriter5"))->Fork(RWWriter, 5);
+
+	currentThread->Yield();
+}
+
+//----------------------------------------------------------------------
+// myTest_Alarm
+// 	Several threads sleep for different lengths of time.  Each
+//	should wake up no earlier than it asked for, and the clock
+//	should fast-forward while everyone is asleep.
+//
+//	Then the same again on an alarm with 100 ticks of slack (as
+//	"-as 100" would give): the sleeper that wants to wake at 1000
+//	should share the alarm at 1050, not wake up early at 1000, nor
+//	make the one that wants 1050 wake early.
+//----------------------------------------------------------------------
+
+Alarm *slackAlarm;
+
+void
+Sleeper(IntPtr ticks)
+{
+	int start = stats->totalTicks;
+
+	currentThread->SleepFor(ticks);
+	ASSERT(stats->totalTicks >= start + ticks);
+	printf("%s slept %d ticks, woke at %d\n", currentThread->getName(),
+					(int) ticks, stats->totalTicks);
+}
+
+void
+SlackSleeper(IntPtr ticks)
+{
+	int start = stats->totalTicks;
+
+	slackAlarm->SleepFor(ticks);
+	ASSERT(stats->totalTicks >= start + ticks);
+	ASSERT(stats->totalTicks <= start + ticks + 100);
+	printf("%s slept %d ticks, woke at %d\n", currentThread->getName(),
+					(int) ticks, stats->totalTicks);
+}
+
+void
+myTest_Alarm()
+{
+	(new Thread("sleeper 1"))->Fork(Sleeper, 5000);
+	(new Thread("sleeper 2"))->Fork(Sleeper, 1000);
+	(new Thread("sleeper 3"))->Fork(Sleeper, 1005);
+	(new Thread("sleeper 4"))->Fork(Sleeper, 20000);
+
+	currentThread->SleepFor(30000);
+	printf("Idle ticks %d, total ticks %d\n", stats->idleTicks,
+					stats->totalTicks);
+
+	slackAlarm = new Alarm(100);
+	(new Thread("slack sleeper 1"))->Fork(SlackSleeper, 1050);
+	(new Thread("slack sleeper 2"))->Fork(SlackSleeper, 1000);
+	(new Thread("slack sleeper 3"))->Fork(SlackSleeper, 1200);
+
+	currentThread->SleepFor(2000);
+	delete slackAlarm;
+}
+
+//----------------------------------------------------------------------
+// myTest_SynchQueue
+// 	Two producers put numbered items through a small SynchQueue in
+//	batches, while two consumers take them out in batches.  No item
+//	should be lost or duplicated.
+//----------------------------------------------------------------------
+
+#define QueueItems	100		// items per producer
+#define QueueBatch	6		// bigger than the queue, so PutN waits
+
+SynchQueue *testQueue;
+int timesGotten[2][QueueItems];		// # of times each item came out
+int numGotten = 0;
+
+void
+QueueProducer(IntPtr which)
+{
+	void *batch[QueueBatch];
+	int next = 0, n;
+
+	while (next < QueueItems) {
+		for (n = 0; n < QueueBatch && next < QueueItems; n++, next++)
+			batch[n] = (void *) (which * 1000 + next + 1);
+		testQueue->PutN(batch, n);
+	}
+}
+
+void
+QueueConsumer(IntPtr which)
+{
+	void *batch[3];
+	int n, i, item;
+
+	while (numGotten < 2 * QueueItems) {
+		n = testQueue->GetN(batch, 3);
+		for (i = 0; i < n; i++) {
+			item = (int) (IntPtr) batch[i] - 1;
+			timesGotten[item / 1000][item % 1000]++;
+		}
+		numGotten += n;
+		currentThread->Yield();
+	}
+}
+
+void
+myTest_SynchQueue()
+{
+	testQueue = new SynchQueue("test queue", 4);
+
+	(new Thread("consumer 0"))->Fork(QueueConsumer, 0);
+	(new Thread("producer 0"))->Fork(QueueProducer, 0);
+	(new Thread("producer 1"))->Fork(QueueProducer, 1);
+	(new Thread("consumer 1"))->Fork(QueueConsumer, 1);
+
+	while (numGotten < 2 * QueueItems)
+		currentThread->Yield();
+	for (int i = 0; i < QueueItems; i++)
+		ASSERT(timesGotten[0][i] == 1 && timesGotten[1][i] == 1);
+	ASSERT(testQueue->NumInQueue() == 0 && testQueue->TryGet() == NULL);
+	ASSERT(testQueue->TryPut((void *) 1) && testQueue->TryGet() == (void *) 1);
+	printf("Passed %d items through a queue of %d\n", numGotten,
+					testQueue->Size());
+}
+
+//----------------------------------------------------------------------
+// myTest_Barrier
+// 	A group of threads goes through several phases, meeting at a
+//	Barrier and then at a TreeBarrier in each one.  No thread should
+//	get past a barrier before everyone has arrived, the action should
+//	run once per phase, and exactly one thread per phase should be
+//	told it was the last to arrive.
+//----------------------------------------------------------------------
+
+#define BarrierThreads	10
+#define BarrierPhases	4
+
+Barrier *flatBarrier;
+TreeBarrier *treeBarrier;
+int arrivals[2][BarrierPhases];		// # arrived, per barrier and phase
+int phasesDone[2];			// # of actions run, per barrier
+int numLast[2];				// # of times TRUE was returned
+
+void
+BarrierPhaseDone(IntPtr kind)
+{
+	ASSERT(arrivals[kind][phasesDone[kind]] == BarrierThreads);
+	phasesDone[kind]++;
+}
+
+void
+BarrierWorker(IntPtr which)
+{
+	for (int phase = 0; phase < BarrierPhases; phase++) {
+		arrivals[0][phase]++;
+		if (flatBarrier->waitOnBarrier())
+			numLast[0]++;
+		ASSERT(arrivals[0][phase] == BarrierThreads);
+		if ((which + phase) % 3 == 0)
+			currentThread->Yield();		// mix up the order
+
+		arrivals[1][phase]++;
+		if (treeBarrier->waitOnBarrier((int) which))
+			numLast[1]++;
+		ASSERT(arrivals[1][phase] == BarrierThreads);
+	}
+}
+
+void
+myTest_Barrier()
+{
+	int tids[BarrierThreads];
+	int i;
+
+	flatBarrier = new Barrier("flat barrier", BarrierThreads);
+	flatBarrier->setAction(BarrierPhaseDone, 0);
+	treeBarrier = new TreeBarrier("tree barrier", BarrierThreads, 3);
+	treeBarrier->setAction(BarrierPhaseDone, 1);
+
+	for (i = 0; i < BarrierThreads; i++) {
+		Thread *t = new Thread("barrier worker");
+		tids[i] = t->getTID();
+		t->Fork(BarrierWorker, i);
+	}
+	for (i = 0; i < BarrierThreads; i++)
+		threadTable->Join(tids[i]);
+
+	ASSERT(phasesDone[0] == BarrierPhases && phasesDone[1] == BarrierPhases);
+	ASSERT(numLast[0] == BarrierPhases && numLast[1] == BarrierPhases);
+	ASSERT(flatBarrier->getPhase() == BarrierPhases);
+	ASSERT(treeBarrier->getPhase() == BarrierPhases);
+	printf("%d threads passed %d barrier phases\n", BarrierThreads,
+					flatBarrier->getPhase());
+}
+
+//----------------------------------------------------------------------
+// myTest_WorkPool
+// 	Submit a batch of work items of very different lengths to a small
+//	pool, some of which post more work of their own, and check every
+//	future gets the right result and every posted item runs.  The long
+//	items hold up their workers' queues, so the others should steal.
+//----------------------------------------------------------------------
+
+#define PoolWorkers	3
+#define PoolItems	24
+
+WorkPool *testPool;
+int numPosted;				// # of posted items that have run
+
+int
+PostedWork(IntPtr arg)
+{
+	numPosted++;
+	return 0;
+}
+
+int
+SquareWork(IntPtr n)
+{
+	for (int i = 0; i < (n % PoolWorkers == 0 ? 10 : 1); i++)
+		currentThread->Yield();
+	if (n % 4 == 0)
+		testPool->Post(PostedWork, n);
+	return (int) (n * n);
+}
+
+void
+myTest_WorkPool()
+{
+	Future *futures[PoolItems];
+	int i;
+
+	testPool = new WorkPool("pool worker", PoolWorkers);
+	for (i = 0; i < PoolItems; i++)
+		futures[i] = testPool->Submit(SquareWork, i);
+	for (i = PoolItems - 1; i >= 0; i--) {
+		ASSERT(futures[i]->Wait() == i * i);
+		delete futures[i];
+	}
+	testPool->Print();
+	delete testPool;			// finishes the posted work
+	ASSERT(numPosted == PoolItems / 4);
+	printf("Pool of %d ran %d items, and %d posted by them\n",
+			PoolWorkers, PoolItems, numPosted);
+}
@@ -17,9 +17,17 @@
 #ifdef HOST_SPARC
 #include <stdarg.h>
 #else
+#ifdef HOST_x86_64
+// the stdarg.h in this directory finds the arguments by walking the
+// stack, but here they are passed in registers -- use the compiler's own
+#define va_list			__builtin_va_list
+#define va_start(ap, last)	__builtin_va_start(ap, last)
+#define va_end(ap)		__builtin_va_end(ap)
+#else
 #include "stdarg.h"
 #endif
 #endif
+#endif
 
 static char *enableFlags = NULL; // controls which DEBUG messages are printed 
 
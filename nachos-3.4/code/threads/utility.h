@@ -39,6 +39,13 @@
 #define divRoundDown(n,s)  ((n) / (s))
 #define divRoundUp(n,s)    (((n) / (s)) + ((((n) % (s)) > 0) ? 1 : 0))
 
+// "IntPtr" is an integer big enough to hold a pointer -- 32 bits on
+// the i386, 64 bits on the x86-64.  Anything that might be passed a
+// pointer disguised as an integer (the argument to a forked thread or
+// an interrupt handler, for instance) should be declared as an IntPtr.
+
+typedef long IntPtr;
+
 // This declares the type "VoidFunctionPtr" to be a "pointer to a
 // function taking an integer argument and returning nothing".  With
 // such a function pointer (say it is "func"), we can call it like this:
@@ -46,9 +53,10 @@
 //	(*func) (17);
 //
 // This is used by Thread::Fork and for interrupt handlers, as well
-// as a couple of other places.
+// as a couple of other places.  The argument is often a pointer cast
+// to an integer, so it is an IntPtr.
 
-typedef void (*VoidFunctionPtr)(int arg); 
+typedef void (*VoidFunctionPtr)(IntPtr arg); 
 typedef void (*VoidNoArgFunctionPtr)(); 
 
 
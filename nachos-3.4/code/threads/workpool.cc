@@ -0,0 +1,317 @@
+// workpool.cc
+//	Routines for a pool of kernel worker threads, and for the futures
+//	they hand back results through.
+//
+//	Each worker runs the work on its own queue, oldest first; when its
+//	queue is empty, it steals the oldest piece of work from the next
+//	worker along that has any.  Only when there is no work anywhere
+//	does it go to sleep, on the list of idle workers.
+//
+// Copyright (c) 1992-1993 The Regents of the University of California.
+// All rights reserved.  See copyright.h for copyright notice and limitation
+// of liability and disclaimer of warranty provisions.
+
+#include "copyright.h"
+#include "workpool.h"
+#include "system.h"
+
+//----------------------------------------------------------------------
+// Future::Future
+// 	Initialize a future for a piece of work that hasn't finished.
+//----------------------------------------------------------------------
+
+Future::Future()
+{
+    done = FALSE;
+    result = 0;
+    waiters = new List;
+}
+
+//----------------------------------------------------------------------
+// Future::~Future
+// 	De-allocate a future.  Assume no one is still waiting on it!
+//----------------------------------------------------------------------
+
+Future::~Future()
+{
+    ASSERT(waiters->IsEmpty());
+    delete waiters;
+}
+
+//----------------------------------------------------------------------
+// Future::Wait
+// 	Wait until the work has finished, and return its result.
+//	Returns right away if it has already finished.
+//----------------------------------------------------------------------
+
+int
+Future::Wait()
+{
+    IntStatus oldLevel = interrupt->SetLevel(IntOff);
+
+    while (!done) {
+	waiters->SortedInsert((void *)currentThread, currentThread->priority);
+	currentThread->Sleep();
+    }
+    (void) interrupt->SetLevel(oldLevel);
+    return result;
+}
+
+//----------------------------------------------------------------------
+// Future::Complete
+// 	The work has finished, with "value"; wake up every thread
+//	waiting for it, all at once.
+//----------------------------------------------------------------------
+
+void
+Future::Complete(int value)
+{
+    IntStatus oldLevel = interrupt->SetLevel(IntOff);
+
+    ASSERT(!done);
+    result = value;
+    done = TRUE;
+    scheduler->ReadyToRunAll(waiters);
+    (void) interrupt->SetLevel(oldLevel);
+}
+
+//----------------------------------------------------------------------
+// WorkerRoot
+// 	Dummy function because C++ can't fork a member function.
+//----------------------------------------------------------------------
+
+static void
+WorkerRoot(IntPtr arg)
+{
+    Worker *worker = (Worker *) arg;
+
+    worker->pool->RunWorker(worker);
+}
+
+//----------------------------------------------------------------------
+// WorkPool::WorkPool
+// 	Create the worker threads, each with an empty queue.  They go
+//	to sleep until there is work for them.
+//
+//	"debugName" is an arbitrary name, useful for debugging.
+//	"num" is the number of worker threads.
+//----------------------------------------------------------------------
+
+WorkPool::WorkPool(char* debugName, int num)
+{
+    ASSERT(num > 0);
+    name = debugName;
+    numWorkers = num;
+    nextWorker = 0;
+    idleWorkers = new List;
+    stopping = FALSE;
+
+    workers = new Worker[numWorkers];
+    for (int i = 0; i < numWorkers; i++) {
+	workers[i].pool = this;
+	workers[i].thread = new Thread(name);
+	workers[i].tid = workers[i].thread->getTID();
+	workers[i].queue = new List;
+	workers[i].idle = FALSE;
+	workers[i].numDone = workers[i].numStolen = 0;
+    }
+    for (int i = 0; i < numWorkers; i++)
+	workers[i].thread->Fork(WorkerRoot, (IntPtr) &workers[i]);
+}
+
+//----------------------------------------------------------------------
+// WorkPool::~WorkPool
+// 	De-allocate the pool, after finishing any work still queued.
+//----------------------------------------------------------------------
+
+WorkPool::~WorkPool()
+{
+    if (!stopping)
+	Shutdown();
+    for (int i = 0; i < numWorkers; i++)
+	delete workers[i].queue;
+    delete [] workers;
+    delete idleWorkers;
+}
+
+//----------------------------------------------------------------------
+// WorkPool::Wake
+// 	Wake up "worker", if it is asleep waiting for work.
+//	Called with interrupts disabled.
+//----------------------------------------------------------------------
+
+void
+WorkPool::Wake(Worker *worker)
+{
+    if (worker->idle) {
+	worker->idle = FALSE;
+	(void) idleWorkers->RemoveItem((void *)worker);
+	scheduler->ReadyToRun(worker->thread);
+    }
+}
+
+//----------------------------------------------------------------------
+// WorkPool::Enqueue
+// 	Put a piece of work on a queue, and make sure some worker will
+//	get to it.  Work from a worker of this pool goes on its own queue;
+//	work from anyone else goes on each queue in turn.
+//----------------------------------------------------------------------
+
+void
+WorkPool::Enqueue(WorkItem *item)
+{
+    IntStatus oldLevel = interrupt->SetLevel(IntOff);
+    Worker *worker = NULL;
+
+    ASSERT(!stopping);
+    for (int i = 0; i < numWorkers; i++)
+	if (workers[i].thread == currentThread)
+	    worker = &workers[i];
+    if (worker == NULL) {
+	worker = &workers[nextWorker];
+	nextWorker = (nextWorker + 1) % numWorkers;
+    }
+    worker->queue->Append((void *)item);
+
+    if (worker->idle)
+	Wake(worker);
+    else if (!idleWorkers->IsEmpty())		// someone can steal it
+	Wake((Worker *) idleWorkers->Front(NULL));
+    (void) interrupt->SetLevel(oldLevel);
+}
+
+//----------------------------------------------------------------------
+// WorkPool::Submit
+// 	Queue up "func(arg)" to be run by some worker, and return a
+//	future for its result.  The caller must delete the future.
+//----------------------------------------------------------------------
+
+Future *
+WorkPool::Submit(WorkFunction func, IntPtr arg)
+{
+    WorkItem *item = new WorkItem;
+
+    item->func = func;
+    item->arg = arg;
+    item->future = new Future;
+    Enqueue(item);
+    return item->future;
+}
+
+//----------------------------------------------------------------------
+// WorkPool::Post
+// 	Queue up "func(arg)" to be run by some worker; its result is
+//	thrown away.
+//----------------------------------------------------------------------
+
+void
+WorkPool::Post(WorkFunction func, IntPtr arg)
+{
+    WorkItem *item = new WorkItem;
+
+    item->func = func;
+    item->arg = arg;
+    item->future = NULL;
+    Enqueue(item);
+}
+
+//----------------------------------------------------------------------
+// WorkPool::Dequeue
+// 	Take the oldest piece of work off "worker"'s own queue; if there
+//	isn't any, steal the oldest piece from the next worker that has
+//	some.  Return NULL if there is no work anywhere.
+//	Called with interrupts disabled.
+//----------------------------------------------------------------------
+
+WorkItem *
+WorkPool::Dequeue(Worker *worker)
+{
+    WorkItem *item = (WorkItem *) worker->queue->Remove();
+    int self = worker - workers;
+
+    for (int i = 1; item == NULL && i < numWorkers; i++) {
+	item = (WorkItem *) workers[(self + i) % numWorkers].queue->Remove();
+	if (item != NULL) {
+	    DEBUG('t', "Worker %d of \"%s\" stole work from worker %d\n",
+				self, name, (self + i) % numWorkers);
+	    worker->numStolen++;
+	}
+    }
+    return item;
+}
+
+//----------------------------------------------------------------------
+// WorkPool::RunWorker
+// 	The body of each worker thread: run work, from our own queue or
+//	stolen, until there is none left; then sleep until there is more.
+//	Return (finishing the thread) once the pool is shut down and
+//	there is no work left.
+//----------------------------------------------------------------------
+
+void
+WorkPool::RunWorker(Worker *worker)
+{
+    IntStatus oldLevel;
+    WorkItem *item;
+    int result;
+
+    for (;;) {
+	oldLevel = interrupt->SetLevel(IntOff);
+	while ((item = Dequeue(worker)) == NULL) {
+	    if (stopping) {
+		(void) interrupt->SetLevel(oldLevel);
+		return;
+	    }
+	    worker->idle = TRUE;
+	    idleWorkers->Append((void *)worker);
+	    currentThread->Sleep();
+	}
+	(void) interrupt->SetLevel(oldLevel);
+
+	result = (*item->func)(item->arg);
+	if (item->future != NULL)
+	    item->future->Complete(result);
+	delete item;
+	worker->numDone++;
+    }
+}
+
+//----------------------------------------------------------------------
+// WorkPool::Shutdown
+// 	Let the workers finish all the work that has been queued, then
+//	wait for them to exit.  No more work may be submitted.  Must not
+//	be called by one of the pool's own workers.
+//----------------------------------------------------------------------
+
+void
+WorkPool::Shutdown()
+{
+    IntStatus oldLevel = interrupt->SetLevel(IntOff);
+    Worker *worker;
+
+    ASSERT(!stopping);
+    stopping = TRUE;
+    while ((worker = (Worker *) idleWorkers->Front(NULL)) != NULL)
+	Wake(worker);
+    (void) interrupt->SetLevel(oldLevel);
+
+    for (int i = 0; i < numWorkers; i++) {
+	ASSERT(workers[i].thread != currentThread);
+	threadTable->Join(workers[i].tid);
+    }
+}
+
+//----------------------------------------------------------------------
+// WorkPool::Print
+// 	Print how much work each worker has done, and how much of it it
+//	stole.  For debugging and tuning.
+//----------------------------------------------------------------------
+
+void
+WorkPool::Print()
+{
+    printf("Work pool \"%s\":\n", name);
+    for (int i = 0; i < numWorkers; i++)
+	printf("\tworker %d: %d done, %d stolen\n", i,
+		workers[i].numDone, workers[i].numStolen);
+}
@@ -0,0 +1,117 @@
+// workpool.h
+//	Data structures for a pool of kernel worker threads, which run
+//	short pieces of work ("work items") on behalf of the rest of the
+//	kernel -- instead of creating, and then destroying, a new thread
+//	(and stack) for every piece of work.
+//
+//	The pool has a fixed number of workers, which bounds how many
+//	pieces of work are in progress at once.  Each worker has its own
+//	queue of work.  Work submitted from outside the pool is spread
+//	over the queues in turn; work submitted by a worker goes on its
+//	own queue.  A worker whose queue is empty "steals" work from the
+//	other queues before going to sleep.
+//
+//	Submit returns a Future, which the caller can Wait on for the
+//	work's result; Post is for work no one waits for.
+//
+// Copyright (c) 1992-1993 The Regents of the University of California.
+// All rights reserved.  See copyright.h for copyright notice and limitation
+// of liability and disclaimer of warranty provisions.
+
+#ifndef WORKPOOL_H
+#define WORKPOOL_H
+
+#include "copyright.h"
+#include "list.h"
+#include "thread.h"
+
+// A piece of work: a function to call, with its argument, that
+// returns a result.
+typedef int (*WorkFunction)(IntPtr arg);
+
+// The following class defines a "future" -- the result of a piece of
+// work, which may not be finished yet.  The thread that submitted the
+// work owns the future, and deletes it once it is done with it.
+
+class Future {
+  public:
+    Future();			// initialize a future that isn't done
+    ~Future();			// de-allocate; no one may be waiting
+
+    int Wait();			// wait until the work is done, and
+				// return its result
+    bool IsDone() { return done; }	// has the work finished?
+
+    void Complete(int value);	// called by the worker when the work
+				// is done; wake up anyone in Wait
+
+  private:
+    bool done;			// has the work finished?
+    int result;			// what it returned, once it has
+    List *waiters;		// threads in Wait, by priority
+};
+
+// The following class defines one piece of work on a worker's queue.
+
+class WorkItem {
+  public:
+    WorkFunction func;		// what to call
+    IntPtr arg;			// what to pass it
+    Future *future;		// where to put the result; NULL if
+				// no one is waiting for it
+};
+
+// The following class defines one worker thread in a pool.
+//
+// Internal data structures kept public so that WorkPool operations can
+// access them directly.
+
+class WorkPool;
+
+class Worker {
+  public:
+    WorkPool *pool;		// the pool we belong to
+    Thread *thread;		// the thread that does the work
+    int tid;			// its TID, to Join it at shutdown
+    List *queue;		// work waiting for this worker
+    bool idle;			// asleep, waiting for work?
+    int numDone;		// # of work items run
+    int numStolen;		// # of them taken from other queues
+};
+
+// The following class defines a pool of worker threads.
+//
+// All operations assume a uniprocessor; they disable interrupts
+// internally where they need to be atomic.
+
+class WorkPool {
+  public:
+    WorkPool(char* debugName, int numWorkers);	// start up the workers
+    ~WorkPool();			// shut down, if not done already
+
+    Future *Submit(WorkFunction func, IntPtr arg);	// queue up work,
+					// and return its future
+    void Post(WorkFunction func, IntPtr arg);	// queue up work no one
+					// will wait for
+    void Shutdown();			// finish all queued work, then
+					// stop the workers
+
+    void RunWorker(Worker *worker);	// body of each worker thread
+    void Print();			// print per-worker statistics
+
+  private:
+    char* name;				// useful for debugging
+    Worker *workers;			// one per worker thread
+    int numWorkers;
+    int nextWorker;			// whose queue gets the next piece
+					// of work from outside the pool
+    List *idleWorkers;			// workers asleep, waiting for work
+    bool stopping;			// Shutdown has been called
+
+    void Enqueue(WorkItem *item);	// put work on a queue
+    WorkItem *Dequeue(Worker *worker);	// take work off our own queue,
+					// or steal it; NULL if none
+    void Wake(Worker *worker);		// wake up an idle worker
+};
+
+#endif // WORKPOOL_H
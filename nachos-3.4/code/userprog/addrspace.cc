@@ -154,6 +154,7 @@ AddrSpace::AddrSpace(OpenFile *executable)
 
 AddrSpace::~AddrSpace()
 {
+   scheduler->UnloadAddrSpace(this);
    delete pageTable;
 }
 
@@ -15,6 +15,7 @@
 
 #include "copyright.h"
 #include "filesys.h"
+#include "stats.h"
 
 #define UserStackSize		1024 	// increase this as necessary!
 
@@ -36,6 +37,8 @@ class AddrSpace {
     unsigned int numPages;		// Number of pages in the virtual 
 					// address space
     char *diskSpace;
+    UsageStats usage;			// resources used by all the threads
+					// running in this address space
 };
 
 #endif // ADDRSPACE_H
@@ -106,6 +106,34 @@ BitMap::Find()
     return -1;
 }
 
+//----------------------------------------------------------------------
+// BitMap::FindRun
+// 	Return the # of the first of "count" clear bits in a row, and as
+//	a side effect, set them all.  If there is no such run, return -1,
+//	and leave the bitmap alone.
+//
+//	"count" is the number of bits wanted
+//----------------------------------------------------------------------
+
+int
+BitMap::FindRun(int count)
+{
+    int first = 0;
+
+    for (int i = 0; i < numBits; i++) {
+	if (Test(i)) {
+	    first = i + 1;
+	    continue;
+	}
+	if (i - first + 1 == count) {
+	    for (int j = first; j <= i; j++)
+		Mark(j);
+	    return first;
+	}
+    }
+    return -1;
+}
+
 //----------------------------------------------------------------------
 // BitMap::NumClear
 // 	Return the number of clear bits in the bitmap.
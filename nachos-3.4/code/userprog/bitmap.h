@@ -44,6 +44,8 @@ class BitMap {
     int Find();            	// Return the # of a clear bit, and as a side
 				// effect, set the bit. 
 				// If no bits are clear, return -1.
+    int FindRun(int count);	// Likewise, for "count" clear bits in a
+				// row; return the # of the first.
     int NumClear();		// Return the number of clear bits
 
     void Print();		// Print contents of bitmap
@@ -21,6 +21,8 @@
 // All rights reserved.  See copyright.h for copyright notice and limitation 
 // of liability and disclaimer of warranty provisions.
 
+#include <sys/stat.h>		// for mkdir
+#include <stdlib.h>		// for system
 #include "copyright.h"
 #include "system.h"
 #include "syscall.h"
@@ -28,13 +30,6 @@
 #include "synch.h"
 #include "machine.h"
 
-typedef struct 
-{
-	Thread *p;
-	bool b = false;
-}aa;
-
-extern aa *a;
 extern void StartProcess(char*);
 
 extern BitMap *memBitMap;
@@ -174,19 +169,24 @@ void replacePage(int ppn)
 	
 }
 
-void func_Exec(int filename)
+void func_Exec(IntPtr filename)
 {
 	printf("%s executes a file named %s\n", currentThread->getName(), filename);
 	StartProcess((char*)filename);
 	ASSERT(FALSE);
 }
 
-void func_Fork(int funcPointer)
+void func_Fork(IntPtr funcPointer)
 {   
-    currentThread->space = a[0].p->space;
-    currentThread->executable = a[0].p->executable;
+    Thread *mainThread = threadTable->Lookup(0);
+
+    currentThread->space = mainThread->space;
+    currentThread->executable = mainThread->executable;
     //delete executable;			// close file
 
+    scheduler->AdoptUserState();	// start from the forking thread's
+					// registers, still in the machine
+
     machine->WriteRegister(PCReg, funcPointer);
     machine->WriteRegister(NextPCReg, funcPointer+4);
 
@@ -211,7 +211,10 @@ ExceptionHandler(ExceptionType which)
 		DEBUG('a', "Exit, initiated by user program.\n");
 		int exitCode = machine->registers[4];
 		printf("Exit with %d\n", exitCode);
+		currentThread->usage.Print(currentThread->getName());
+		currentThread->space->usage.Print("  address space");
 		//interrupt->Halt();
+		currentThread->exitStatus = exitCode;	// for Join
 		currentThread->Finish();
 		machine->registers[PCReg] = machine->registers[NextPCReg];
 		machine->registers[NextPCReg] = machine->registers[PCReg] + 4; 
@@ -238,7 +241,7 @@ ExceptionHandler(ExceptionType which)
 		}
 		
 		Thread *t = new Thread("forked thread 2");
-   		t->Fork(func_Exec, (int)filename);
+   		t->Fork(func_Exec, (IntPtr)filename);
 
 		SpaceId id = t->getTID();
 		machine->WriteRegister(2, id);			
@@ -248,10 +251,11 @@ ExceptionHandler(ExceptionType which)
     else if((which == SyscallException) && (type == SC_Join)) {
 		DEBUG('a', "Join, initiated by user program.\n");
 		SpaceId id = machine->ReadRegister(4);
-		while(a[id].b == true) {
-			printf("%s yields waiting for %s\n", currentThread->getName(), (a[id].p)->getName());
-			currentThread->Yield();
-		}
+		int exitCode = -1;
+
+		if (id != currentThread->getTID())	// itself: would wait forever
+			exitCode = threadTable->Join(id);
+		machine->WriteRegister(2, exitCode);
 		
 		machine->registers[PCReg] = machine->registers[NextPCReg];
 		machine->registers[NextPCReg] = machine->registers[PCReg] + 4; 
@@ -368,6 +372,8 @@ ExceptionHandler(ExceptionType which)
     else if(which == TLBMissException) {
 		DEBUG('a', "TLBMissException, initiated by user program.\n");
 		stats->numTLBmiss++;
+		currentThread->usage.numTLBmiss++;
+		currentThread->space->usage.numTLBmiss++;
 		TranslationEntry *entry = findOneTLBToRelpace();
 		replaceTLB(entry);
  		//printf("TLB miss times: %d\n", stats->numTLBmiss);
@@ -375,6 +381,8 @@ ExceptionHandler(ExceptionType which)
     else if(which == PageFaultException) {
 		DEBUG('a', "PageFaultException, initiated by user program.\n");
 		stats->numPageFaults++;
+		currentThread->usage.numPageFaults++;
+		currentThread->space->usage.numPageFaults++;
 		int ppn = findOnePageToRelpace();
 		replacePage(ppn);
 		//printf("PageFault times: %d\n", stats->numPageFaults);
@@ -443,6 +451,33 @@ ExceptionHandler(ExceptionType which)
 		machine->registers[PCReg] = machine->registers[NextPCReg];
 		machine->registers[NextPCReg] = machine->registers[PCReg] + 4; 
 	}
+    else if((which == SyscallException) && (type == SC_Sleep)) {
+		DEBUG('a', "Sleep, initiated by user program.\n");
+		int ticks = machine->ReadRegister(4);
+		currentThread->SleepFor(ticks);
+		machine->registers[PCReg] = machine->registers[NextPCReg];
+		machine->registers[NextPCReg] = machine->registers[PCReg] + 4; 
+	}
+    else if((which == SyscallException) && (type == SC_GetStats)) {
+		DEBUG('a', "GetStats, initiated by user program.\n");
+		int usageAddr = machine->ReadRegister(4);
+		int scope = machine->ReadRegister(5);
+		UsageStats *u = NULL;
+		if(scope == UsageThread)
+			u = &currentThread->usage;
+		else if(scope == UsageProcess)
+			u = &currentThread->space->usage;
+		if(u != NULL) {
+			int fields[] = { u->userTicks, u->systemTicks,
+					 u->numPageFaults, u->numTLBmiss,
+					 u->numDiskReads, u->numDiskWrites };
+			for(int i = 0; i < (int) (sizeof(Usage) / sizeof(int)); i++)
+				while(!machine->WriteMem(usageAddr + i * 4, 4, fields[i]));
+		}
+		machine->WriteRegister(2, u != NULL ? 0 : -1);
+		machine->registers[PCReg] = machine->registers[NextPCReg];
+		machine->registers[NextPCReg] = machine->registers[PCReg] + 4; 
+	}
     else {
 	printf("Unexpected user mode exception %d %d\n", which, type);
 	ASSERT(FALSE);
@@ -35,8 +35,9 @@ StartProcess(char *filename)
 
     delete executable;			// close file
 
+    scheduler->AdoptUserState();	// take over the machine registers,
+					// and load page table register
     space->InitRegisters();		// set the initial register values
-    space->RestoreState();		// load page table register
 
     machine->Run();			// jump to the user progam
     ASSERT(FALSE);			// machine->Run never returns;
@@ -56,8 +57,8 @@ static Semaphore *writeDone;
 // 	Wake up the thread that requested the I/O.
 //----------------------------------------------------------------------
 
-static void ReadAvail(int arg) { readAvail->V(); }
-static void WriteDone(int arg) { writeDone->V(); }
+static void ReadAvail(IntPtr arg) { readAvail->V(); }
+static void WriteDone(IntPtr arg) { writeDone->V(); }
 
 //----------------------------------------------------------------------
 // ConsoleTest
@@ -33,6 +33,8 @@
 #define SC_RemoveDir    12
 #define SC_Remove       13
 #define SC_Seek         14
+#define SC_Sleep        15
+#define SC_GetStats     16
 
 #ifndef IN_ASM
 
@@ -64,7 +66,8 @@ typedef int SpaceId;
 SpaceId Exec(char *name);
  
 /* Only return once the the user program "id" has finished.  
- * Return the exit status.
+ * Return the exit status, or -1 if there is no such program (or it is
+ * the caller itself).
  */
 int Join(SpaceId id); 	
  
@@ -128,6 +131,31 @@ void Fork(void (*func)());
  */
 void Yield();		
 
+/* Put the current thread to sleep for "ticks" of simulated time.  Unlike
+ * looping on Yield, this lets the CPU go idle if nothing else can run.
+ */
+void Sleep(int ticks);
+
+/* Resource usage, as filled in by GetStats: what the calling thread,
+ * or all the threads in its address space, have used so far.
+ */
+typedef struct {
+    int userTicks;		/* user instructions executed */
+    int systemTicks;		/* time spent in the kernel */
+    int pageFaults;		/* virtual memory page faults */
+    int tlbMisses;		/* TLB misses */
+    int diskReads;		/* disk sectors read */
+    int diskWrites;		/* disk sectors written */
+} Usage;
+
+#define UsageThread	0	/* just the calling thread */
+#define UsageProcess	1	/* its whole address space */
+
+/* Fill in "usage" for the calling thread, or its whole address space,
+ * depending on "which".  Return 0, or -1 if "which" is neither.
+ */
+int GetStats(Usage *usage, int which);
+
 void Seek(OpenFileId id, int offset);
 
 void Remove(char* name);